@@ -17,23 +17,42 @@
 
 #pragma once
 
+#include "kogge_stone.h"
 #include "magic.h"
 #include "masks.h"
 
 namespace chess {
 
     [[nodiscard]] Bitboard attacks_rook(Square square, Bitboard occ) {
-        const Magic &m = magic_rook[square];
-        return m.ptr[get_magic_index(m, occ)];
+#ifdef KOGGE_STONE
+        return kogge_stone::attacks_rook(square, occ);
+#else
+        return lookup_magic<ROOK>(magic_rook[square], occ);
+#endif
     }
 
     [[nodiscard]] Bitboard attacks_bishop(Square square, Bitboard occ) {
-        const Magic &m = magic_bishop[square];
-        return m.ptr[get_magic_index(m, occ)];
+#ifdef KOGGE_STONE
+        return kogge_stone::attacks_bishop(square, occ);
+#else
+        return lookup_magic<BISHOP>(magic_bishop[square], occ);
+#endif
     }
 
     [[nodiscard]] Bitboard attacks_queen(Square square, Bitboard occ) {
+#ifdef KOGGE_STONE
+        return kogge_stone::attacks_queen(square, occ);
+#else
         return attacks_rook(square, occ) | attacks_bishop(square, occ);
+#endif
+    }
+
+    [[nodiscard]] const char *get_sliding_attacks_name() {
+#ifdef KOGGE_STONE
+        return "kogge-stone";
+#else
+        return get_magic_index_name();
+#endif
     }
 
     template<PieceType pt>
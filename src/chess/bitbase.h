@@ -0,0 +1,240 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "attacks.h"
+#include "board.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Win/draw bitbases of a king and a queen, rook or pawn against a lone king, generated in the background after startup.
+namespace chess::bitbase {
+
+    enum ProbeResult {
+        PROBE_NONE,
+        PROBE_LOSS,
+        PROBE_DRAW,
+        PROBE_WIN
+    };
+
+    // The positions are stored with the stronger side as white, indexed by the side to move, the two kings and the piece.
+    constexpr unsigned int BITBASE_SIZE = 2 * 64 * 64 * 64;
+
+    constexpr unsigned int bitbase_index(Color stm, unsigned int strong_king, unsigned int weak_king, unsigned int piece) {
+        return stm | strong_king << 1 | weak_king << 7 | piece << 13;
+    }
+
+    struct Bitbase {
+        uint64_t wins[BITBASE_SIZE / 64];
+
+        [[nodiscard]] bool is_win(unsigned int index) const {
+            return wins[index / 64] >> (index % 64) & 1;
+        }
+    };
+
+    Bitbase bitbase_queen, bitbase_rook, bitbase_pawn;
+
+    enum GenerationResult : uint8_t {
+        RESULT_INVALID,
+        RESULT_UNKNOWN,
+        RESULT_DRAW,
+        RESULT_WIN
+    };
+
+    // The state of a position during the generation, with the number of moves of the weak side not known to lose
+    struct Entry {
+        uint8_t result : 2;
+        uint8_t moves : 6;
+    };
+
+    template<PieceType pt>
+    Bitboard bitbase_piece_attacks(unsigned int square, Bitboard occupied) {
+        if constexpr (pt == PAWN) {
+            return masks_pawn[square][WHITE];
+        } else {
+            return attacks_piece<pt>(Square(square), occupied);
+        }
+    }
+
+    template<PieceType pt>
+    bool is_valid_position(unsigned int index) {
+        const Color stm = Color(index & 1);
+        const unsigned int strong_king = index >> 1 & 63, weak_king = index >> 7 & 63, piece = index >> 13;
+
+        if (strong_king == weak_king || strong_king == piece || weak_king == piece) return false;
+        if (masks_king[strong_king].get(Square(weak_king))) return false;
+        if (pt == PAWN && (square_to_rank(Square(piece)) == 0 || square_to_rank(Square(piece)) == 7)) return false;
+
+        // The weak side can not be in check when the strong side is to move
+        const Bitboard occupied = Bitboard(Square(strong_king)) | Bitboard(Square(weak_king)) | Bitboard(Square(piece));
+        return stm == BLACK || !bitbase_piece_attacks<pt>(piece, occupied).get(Square(weak_king));
+    }
+
+    // Classifies the position as far as it is possible without the results of the other positions.
+    // The weak side loses if all its moves lose, so their number is returned in moves, to be counted down later.
+    template<PieceType pt>
+    GenerationResult classify(unsigned int index, unsigned int &moves) {
+        if (!is_valid_position<pt>(index)) return RESULT_INVALID;
+
+        const Color stm = Color(index & 1);
+        const unsigned int strong_king = index >> 1 & 63, weak_king = index >> 7 & 63, piece = index >> 13;
+        const Bitboard piece_bb = Bitboard(Square(piece));
+        const Bitboard kings = Bitboard(Square(strong_king)) | Bitboard(Square(weak_king));
+        moves = 0;
+
+        if (stm == BLACK) {
+            // Capturing the undefended piece leaves two kings
+            if (masks_king[weak_king].get(Square(piece)) && !masks_king[strong_king].get(Square(piece))) return RESULT_DRAW;
+
+            // The weak king does not block the attacks on the squares it moves to
+            const Bitboard attacked = masks_king[strong_king] | bitbase_piece_attacks<pt>(piece, Bitboard(Square(strong_king)) | piece_bb);
+            moves = (masks_king[weak_king] & ~attacked & ~piece_bb).pop_count();
+
+            if (moves != 0) return RESULT_UNKNOWN;
+            const bool in_check = bitbase_piece_attacks<pt>(piece, kings | piece_bb).get(Square(weak_king));
+            return in_check ? RESULT_WIN : RESULT_DRAW;
+        }
+
+        if constexpr (pt == PAWN) {
+            // Promotions continue in the queen and rook bitbases, which are generated first
+            const unsigned int push = piece + 8;
+            if (square_to_rank(Square(push)) == 7 && !kings.get(Square(push))) {
+                const unsigned int promoted = bitbase_index(BLACK, strong_king, weak_king, push);
+                if (bitbase_queen.is_win(promoted) || bitbase_rook.is_win(promoted)) return RESULT_WIN;
+            }
+        }
+        return RESULT_UNKNOWN;
+    }
+
+    // Generates the bitbase by retrograde analysis. After classifying every position, the wins are propagated backwards:
+    // a position of the strong side wins if any of its moves wins, and one of the weak side if all of its moves do.
+    // The positions that are not found to be wins are draws.
+    template<PieceType pt>
+    void generate(Bitbase &bitbase) {
+        std::vector<Entry> entries(BITBASE_SIZE);
+        std::vector<unsigned int> wins;
+
+        for (unsigned int index = 0; index < BITBASE_SIZE; index++) {
+            unsigned int moves;
+            const GenerationResult result = classify<pt>(index, moves);
+            entries[index] = {result, uint8_t(moves)};
+            if (result == RESULT_WIN) wins.emplace_back(index);
+        }
+
+        for (size_t i = 0; i < wins.size(); i++) {
+            const unsigned int index = wins[i];
+            const Color stm = Color(index & 1);
+            const unsigned int strong_king = index >> 1 & 63, weak_king = index >> 7 & 63, piece = index >> 13;
+
+            auto retract = [&](unsigned int previous) {
+                Entry &entry = entries[previous];
+                if (entry.result != RESULT_UNKNOWN) return;
+                if (stm == BLACK || --entry.moves == 0) {
+                    entry.result = RESULT_WIN;
+                    wins.emplace_back(previous);
+                }
+            };
+
+            if (stm == WHITE) {
+                // The weak king came from one of its neighbouring squares
+                Bitboard origins = masks_king[weak_king];
+                while (origins) {
+                    retract(bitbase_index(BLACK, strong_king, origins.pop_lsb(), piece));
+                }
+                continue;
+            }
+
+            Bitboard king_origins = masks_king[strong_king];
+            while (king_origins) {
+                retract(bitbase_index(WHITE, king_origins.pop_lsb(), weak_king, piece));
+            }
+
+            const Bitboard kings = Bitboard(Square(strong_king)) | Bitboard(Square(weak_king));
+            if constexpr (pt == PAWN) {
+                if (square_to_rank(Square(piece)) >= 2) retract(bitbase_index(WHITE, strong_king, weak_king, piece - 8));
+                if (square_to_rank(Square(piece)) == 3 && !kings.get(Square(piece - 8))) retract(bitbase_index(WHITE, strong_king, weak_king, piece - 16));
+            } else {
+                Bitboard piece_origins = bitbase_piece_attacks<pt>(piece, kings | Bitboard(Square(piece))) & ~kings;
+                while (piece_origins) {
+                    retract(bitbase_index(WHITE, strong_king, weak_king, piece_origins.pop_lsb()));
+                }
+            }
+        }
+
+        for (const unsigned int index : wins) {
+            bitbase.wins[index / 64] |= 1ULL << (index % 64);
+        }
+    }
+
+    std::atomic<bool> ready = false;
+
+    // The queen and rook bitbases are independent, the pawn one probes both of them for promotions.
+    void generate_all() {
+        std::thread rook_thread(generate<ROOK>, std::ref(bitbase_rook));
+        generate<QUEEN>(bitbase_queen);
+        rook_thread.join();
+        generate<PAWN>(bitbase_pawn);
+
+        ready.store(true, std::memory_order_release);
+        ready.notify_all();
+    }
+
+    // Starts the generation on its own thread, so neither the startup nor a search waits for it.
+    // The probes find nothing until the bitbases are ready.
+    void init() {
+        std::thread(generate_all).detach();
+    }
+
+    // Blocks until the bitbases are ready, for the results that must not depend on the timing of the generation.
+    void wait() {
+        ready.wait(false, std::memory_order_acquire);
+    }
+
+    // Probes the result of positions with a single queen, rook or pawn, for the side to move.
+    ProbeResult probe(const Board &board) {
+        const Bitboard occupied = board.occupied();
+        if (occupied.pop_count() != 3 || !ready.load(std::memory_order_acquire)) return PROBE_NONE;
+
+        const Square square = (occupied ^ board.pieces<KING>()).lsb();
+        const Piece piece = board.piece_at(square);
+
+        const Bitbase *bitbase;
+        if (piece.type == QUEEN) {
+            bitbase = &bitbase_queen;
+        } else if (piece.type == ROOK) {
+            bitbase = &bitbase_rook;
+        } else if (piece.type == PAWN) {
+            bitbase = &bitbase_pawn;
+        } else {
+            return PROBE_NONE;
+        }
+
+        // The stronger side is black in the mirrored position
+        const unsigned int flip = piece.color == WHITE ? 0 : 56;
+        const Color stm = board.get_stm() == piece.color ? WHITE : BLACK;
+        const unsigned int index = bitbase_index(stm, board.pieces<KING>(piece.color).lsb() ^ flip,
+                                                 board.pieces<KING>(color_enemy(piece.color)).lsb() ^ flip, square ^ flip);
+
+        if (!bitbase->is_win(index)) return PROBE_DRAW;
+        return stm == WHITE ? PROBE_WIN : PROBE_LOSS;
+    }
+
+} // namespace chess::bitbase
@@ -39,7 +39,9 @@ namespace chess {
             bb = value;
         }
 
-        Bitboard(Square square);
+        constexpr Bitboard(Square square) {
+            bb = 1ULL << square;
+        }
 
         constexpr Bitboard() = default;
 
@@ -170,6 +172,8 @@ namespace chess {
     constexpr Bitboard RANK_7 = RANK_1 << (6 * 8);
     constexpr Bitboard RANK_8 = RANK_1 << (7 * 8);
 
+    constexpr Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
     constexpr Bitboard masks_side[2] = {RANK_1 | RANK_2 | RANK_3 | RANK_4, RANK_5 | RANK_6 | RANK_7 | RANK_8};
 
     constexpr Bitboard WK_CASTLE_SAFE = 0x70ULL;
@@ -182,12 +186,6 @@ namespace chess {
     constexpr Bitboard BQ_CASTLE_SAFE = 0x1c00000000000000ULL;
     constexpr Bitboard BQ_CASTLE_EMPTY = 0xe00000000000000ULL;
 
-    extern Bitboard masks_bit[64];
-
-    Bitboard::Bitboard(Square square) {
-        bb = masks_bit[square].bb;
-    }
-
     template<Direction direction>
     [[nodiscard]] constexpr Bitboard step(Bitboard b) {
         switch (direction) {
@@ -243,7 +241,7 @@ namespace chess {
         return result;
     }
 
-    [[nodiscard]] Bitboard slide(Direction direction, Square square) {
+    [[nodiscard]] constexpr Bitboard slide(Direction direction, Square square) {
         Bitboard result;
         Bitboard temp = {square};
         while (temp) {
@@ -22,11 +22,12 @@
 #include "attacks.h"
 #include "bitboard.h"
 #include "board_state.h"
+#include "fen.h"
 #include "move.h"
+#include "packed_board.h"
 
 #include <algorithm>
-#include <regex>
-#include <sstream>
+#include <string_view>
 #include <vector>
 
 #define state states.back()
@@ -48,6 +49,18 @@ namespace chess {
             return state.hash;
         }
 
+        [[nodiscard]] inline Zobrist get_pawn_hash() const {
+            return state.pawn_hash;
+        }
+
+        [[nodiscard]] inline Zobrist get_non_pawn_hash(Color color) const {
+            return state.non_pawn_hash[color];
+        }
+
+        [[nodiscard]] inline MaterialKey get_material() const {
+            return state.material;
+        }
+
         [[nodiscard]] inline unsigned int get_move50() const {
             return state.move50;
         }
@@ -117,6 +130,9 @@ namespace chess {
             return cnt >= 2 + is_pv;
         }
 
+        template<Color color>
+        [[nodiscard]] bool is_check() const;
+
         [[nodiscard]] bool is_check() const;
 
         [[nodiscard]] bool has_non_pawn() const {
@@ -162,18 +178,23 @@ namespace chess {
             return hash;
         }
 
+        // The side to move is a template parameter, so the color dependent directions and squares are known at compile time.
+        template<Color stm>
         void make_move(Move move, nn::NNUE *nnue = nullptr) {
+            constexpr Color xstm = color_enemy<stm>();
+            constexpr Direction UP = stm == WHITE ? NORTH : -NORTH;
+            constexpr Direction DOWN = -UP;
+            constexpr Square KING_ROOK_FROM = stm == WHITE ? H1 : H8, KING_ROOK_TO = stm == WHITE ? F1 : F8;
+            constexpr Square QUEEN_ROOK_FROM = stm == WHITE ? A1 : A8, QUEEN_ROOK_TO = stm == WHITE ? D1 : D8;
+
             const Square from = move.get_from();
             const Square to = move.get_to();
             Piece piece_moved = piece_at(from);
-            const Color stm = piece_moved.color;
-            const Color xstm = color_enemy(stm);
             const BoardState state_old = state;
-            const Direction UP = stm == WHITE ? NORTH : -NORTH;
-            const Direction DOWN = -UP;
 
             assert(!states.empty());
             assert(stm == state.stm);
+            assert(stm == piece_moved.color);
 
             states.emplace_back(state);
 
@@ -219,17 +240,9 @@ namespace chess {
             move_piece(piece_moved, from, to, nnue);
 
             if (move.eq_flag(Move::KING_CASTLE)) {
-                if (stm == WHITE) {
-                    move_piece(Piece(ROOK, WHITE), H1, F1, nnue);
-                } else {
-                    move_piece(Piece(ROOK, BLACK), H8, F8, nnue);
-                }
+                move_piece(Piece(ROOK, stm), KING_ROOK_FROM, KING_ROOK_TO, nnue);
             } else if (move.eq_flag(Move::QUEEN_CASTLE)) {
-                if (stm == WHITE) {
-                    move_piece(Piece(ROOK, WHITE), A1, D1, nnue);
-                } else {
-                    move_piece(Piece(ROOK, BLACK), A8, D8, nnue);
-                }
+                move_piece(Piece(ROOK, stm), QUEEN_ROOK_FROM, QUEEN_ROOK_TO, nnue);
             }
 
             if (state.rights[CastlingRights::WHITE_KING] && (from == E1 || from == H1 || to == H1)) {
@@ -248,15 +261,28 @@ namespace chess {
             state.hash.xor_castle(state.rights);
         }
 
+        void make_move(Move move, nn::NNUE *nnue = nullptr) {
+            if (get_stm() == WHITE) {
+                make_move<WHITE>(move, nnue);
+            } else {
+                make_move<BLACK>(move, nnue);
+            }
+        }
+
+        // Takes back a move made by stm, which is the side not to move anymore.
+        template<Color stm>
         void undo_move(Move move, nn::NNUE *nnue = nullptr) {
+            constexpr Direction UP = stm == WHITE ? NORTH : -NORTH;
+            constexpr Direction DOWN = -UP;
+            constexpr Square KING_ROOK_FROM = stm == WHITE ? H1 : H8, KING_ROOK_TO = stm == WHITE ? F1 : F8;
+            constexpr Square QUEEN_ROOK_FROM = stm == WHITE ? A1 : A8, QUEEN_ROOK_TO = stm == WHITE ? D1 : D8;
+
             const Square from = move.get_from();
             const Square to = move.get_to();
             Piece piece_moved = piece_at(to);
-            const Color stm = piece_moved.color;
-            const Direction UP = stm == WHITE ? NORTH : -NORTH;
-            const Direction DOWN = -UP;
 
             assert(states.size() > 1);
+            assert(stm == piece_moved.color);
             if (move.is_capture()) {
                 assert(state.piece_captured.is_ok());
             }
@@ -266,17 +292,9 @@ namespace chess {
             }
 
             if (move.eq_flag(Move::KING_CASTLE)) {
-                if (stm == WHITE) {
-                    move_piece(Piece(ROOK, WHITE), F1, H1, nnue);
-                } else {
-                    move_piece(Piece(ROOK, BLACK), F8, H8, nnue);
-                }
+                move_piece(Piece(ROOK, stm), KING_ROOK_TO, KING_ROOK_FROM, nnue);
             } else if (move.eq_flag(Move::QUEEN_CASTLE)) {
-                if (stm == WHITE) {
-                    move_piece(Piece(ROOK, WHITE), D1, A1, nnue);
-                } else {
-                    move_piece(Piece(ROOK, BLACK), D8, A8, nnue);
-                }
+                move_piece(Piece(ROOK, stm), QUEEN_ROOK_TO, QUEEN_ROOK_FROM, nnue);
             }
 
             move_piece(piece_moved, to, from, nnue);
@@ -290,93 +308,68 @@ namespace chess {
             states.pop_back();
         }
 
-        void load(const std::string &fen, bool validate_fen = false) {
-
-            if (validate_fen && !is_valid_fen(fen)) {
-                print("info", "error", "Invalid fen:", fen);
-                return;
+        void undo_move(Move move, nn::NNUE *nnue = nullptr) {
+            if (get_stm() == WHITE) {
+                undo_move<BLACK>(move, nnue);
+            } else {
+                undo_move<WHITE>(move, nnue);
             }
+        }
 
-            board_clear();
-
-            std::stringstream ss(fen);
-            std::string pieces, stm, rights, ep, move50;
-            ss >> pieces >> stm >> rights >> ep >> move50;
-
-            Square square = A8;
-            for (char c : pieces) {
-                if ('1' <= c && c <= '8') {
-                    square += c - '0';
-                } else if (c == '/') {
-                    square -= 16;
-                } else {
-                    square_set(square, piece_from_char(c));
-                    square += 1;
+        // Returns false if the fen is invalid and validated, in which case the board is left unchanged.
+        bool load(std::string_view fen_str, bool validate_fen = false) {
+            Fen fen;
+            if (!parse_fen(fen_str, fen, validate_fen)) {
+                if (validate_fen) {
+                    print("info", "error", "Invalid fen:", fen_str);
+                    return false;
                 }
+                throw std::runtime_error("Invalid fen string: " + std::string(fen_str));
             }
 
-            if (stm == "w") {
-                state.stm = WHITE;
-            } else if (stm == "b") {
-                state.stm = BLACK;
-                state.hash.xor_stm();
-            } else {
-                throw std::runtime_error("Invalid fen string: " + fen);
-            }
+            load(fen);
+            return true;
+        }
 
-            state.rights = CastlingRights(rights);
-            state.ep = square_from_string(ep);
+        void load(const PackedBoard &packed) {
+            load(unpack(packed));
+        }
 
-            if (!move50.empty() && std::all_of(move50.begin(), move50.end(), ::isdigit)) {
-                state.move50 = std::stoi(move50);
-            } else {
-                state.move50 = 0;
+        void load(const Fen &fen) {
+            board_clear();
+
+            for (Square square = A1; square < 64; square += 1) {
+                if (fen.mailbox[square].is_ok()) square_set(square, fen.mailbox[square]);
             }
 
+            state.stm = fen.stm;
+            if (state.stm == BLACK) state.hash.xor_stm();
+            state.rights = fen.rights;
+            state.ep = fen.ep;
+            state.move50 = fen.move50;
+
             state.hash.xor_castle(state.rights);
             if (state.ep != NULL_SQUARE) {
                 state.hash.xor_ep(state.ep);
             }
         }
 
-        [[nodiscard]] std::string get_fen() const {
-            std::string fen;
-
-            Square square = A8;
-            int empty = 0;
-            while (true) {
-                if (mailbox[square].is_null()) {
-                    empty++;
-                } else {
-                    if (empty) fen += std::to_string(empty);
-                    fen += char_from_piece(mailbox[square]);
-                    empty = 0;
-                }
-
-                if (square == H1) {
-                    break;
-                }
+        [[nodiscard]] Fen to_fen() const {
+            Fen fen;
+            std::copy(std::begin(mailbox), std::end(mailbox), fen.mailbox);
+            fen.stm = get_stm();
+            fen.rights = get_rights();
+            fen.ep = get_ep();
+            fen.move50 = get_move50();
+            return fen;
+        }
 
-                if (square_to_file(square) == 7) {
-                    square -= 15;
-                    if (empty) fen += std::to_string(empty);
-                    fen += '/';
-                    empty = 0;
-                } else {
-                    square += 1;
-                }
-            }
+        [[nodiscard]] std::string get_fen() const {
+            return write_fen(to_fen());
+        }
 
-            if (empty) fen += std::to_string(empty);
-            fen += " ";
-            fen += (get_stm() == WHITE ? "w" : "b");
-            fen += " ";
-            fen += get_rights().to_string();
-            fen += " ";
-            fen += get_ep() == NULL_SQUARE ? "-" : format_square(get_ep());
-            fen += " ";
-            fen += std::to_string(get_move50());
-            return fen;
+        [[nodiscard]] PackedBoard pack() const {
+            return chess::pack(to_fen());
         }
 
         void display() const {
@@ -442,6 +435,12 @@ namespace chess {
             mailbox[square] = NULL_PIECE;
 
             state.hash.xor_piece(square, piece);
+            state.material.remove(piece);
+            if (piece.type == PAWN) {
+                state.pawn_hash.xor_piece(square, piece);
+            } else {
+                state.non_pawn_hash[piece.color].xor_piece(square, piece);
+            }
 
             if (nnue) nnue->deactivate(piece, square);
         }
@@ -455,6 +454,12 @@ namespace chess {
             mailbox[square] = piece;
 
             state.hash.xor_piece(square, piece);
+            state.material.add(piece);
+            if (piece.type == PAWN) {
+                state.pawn_hash.xor_piece(square, piece);
+            } else {
+                state.non_pawn_hash[piece.color].xor_piece(square, piece);
+            }
 
             if (nnue) nnue->activate(piece, square);
         }
@@ -478,18 +483,6 @@ namespace chess {
             states.clear();
             states.emplace_back();
         }
-
-        static bool is_valid_fen(const std::string &fen) {
-            const static std::regex fen_regex("^"
-                                              "([rnbqkpRNBQKP1-8]+\\/){7}"
-                                              "([rnbqkpRNBQKP1-8]+)"
-                                              " [bw]"
-                                              " ([-KQkq]+|)"
-                                              " (([a-h][36])|-)"
-                                              " \\d+"
-                                              ".*");
-            return std::regex_match(fen, fen_regex);
-        }
     };
 
 
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "constants.h"
+#include "material.h"
 #include "zobrist.h"
 
 namespace chess {
@@ -25,6 +26,10 @@ namespace chess {
         Color stm = WHITE;
         Square ep = NULL_SQUARE;
         Zobrist hash = Zobrist();
+        // The keys of the pawns, and of the other pieces of each side including the king
+        Zobrist pawn_hash = Zobrist();
+        Zobrist non_pawn_hash[2] = {};
+        MaterialKey material = MaterialKey();
         Piece piece_captured = NULL_PIECE;
         CastlingRights rights = CastlingRights();
         size_t move50 = 0;
@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <string>
+#include <string_view>
+
 namespace chess {
     struct CastlingRights {
 
@@ -29,52 +32,56 @@ namespace chess {
 
         CastlingRights() = default;
 
-        explicit CastlingRights(const std::string &str) {
+        explicit CastlingRights(std::string_view str) {
             for (char c : str) {
-                if (c == 'K') {
-                    *this += WHITE_KING;
-                } else if (c == 'Q') {
-                    *this += WHITE_QUEEN;
-                } else if (c == 'k') {
-                    *this += BLACK_KING;
-                } else if (c == 'q') {
-                    *this += BLACK_QUEEN;
-                }
+                *this += from_char(c);
+            }
+        }
+
+        // Returns the right denoted by c in a FEN string, or 0 if c is not a right.
+        static constexpr unsigned int from_char(char c) {
+            switch (c) {
+                case 'K':
+                    return WHITE_KING;
+                case 'Q':
+                    return WHITE_QUEEN;
+                case 'k':
+                    return BLACK_KING;
+                case 'q':
+                    return BLACK_QUEEN;
+                default:
+                    return 0;
             }
         }
 
-        CastlingRights &operator+=(const unsigned int &right) {
+        constexpr CastlingRights &operator+=(const unsigned int &right) {
             data |= right;
             return *this;
         }
 
-        CastlingRights &operator-=(const unsigned int &right) {
+        constexpr CastlingRights &operator-=(const unsigned int &right) {
             data &= ~right;
             return *this;
         }
 
-        [[nodiscard]] bool operator[](const unsigned int &right) const {
+        [[nodiscard]] constexpr bool operator[](const unsigned int &right) const {
             return data & right;
         }
 
+        // Writes the rights in FEN notation into out, and returns the end of the written characters.
+        char *write(char *out) const {
+            char *begin = out;
+            if ((*this)[WHITE_KING]) *out++ = 'K';
+            if ((*this)[WHITE_QUEEN]) *out++ = 'Q';
+            if ((*this)[BLACK_KING]) *out++ = 'k';
+            if ((*this)[BLACK_QUEEN]) *out++ = 'q';
+            if (out == begin) *out++ = '-';
+            return out;
+        }
+
         [[nodiscard]] std::string to_string() const {
-            std::string res;
-            if ((*this)[WHITE_KING]) {
-                res += 'K';
-            }
-            if ((*this)[WHITE_QUEEN]) {
-                res += 'Q';
-            }
-            if ((*this)[BLACK_KING]) {
-                res += 'k';
-            }
-            if ((*this)[BLACK_QUEEN]) {
-                res += 'q';
-            }
-            if (res.empty()) {
-                res = "-";
-            }
-            return res;
+            char buffer[4];
+            return std::string(buffer, write(buffer));
         }
     };
 } // namespace chess
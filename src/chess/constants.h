@@ -32,6 +32,38 @@
 #define AVX2
 #endif
 
+#if defined(NATIVE) && defined(__AVX512F__) && defined(__AVX512BW__)
+#define AVX512
+#endif
+
+#if defined(NATIVE) && defined(__AVX512VNNI__)
+#define VNNI512
+#endif
+
+// A DISPATCH build only assumes the x86-64 baseline with popcnt. The hot kernels are compiled
+// for every instruction set below, and the best one supported by the CPU is selected at startup.
+#if defined(DISPATCH)
+#define KERNELS_AVX2
+#define KERNELS_AVX512
+#define KERNELS_VNNI512
+#define TARGET_AVX2 __attribute__((target("popcnt,bmi,avx2")))
+#define TARGET_AVX512 __attribute__((target("popcnt,bmi,avx2,avx512f,avx512bw")))
+#define TARGET_VNNI512 __attribute__((target("popcnt,bmi,avx2,avx512f,avx512bw,avx512vnni")))
+#else
+#if defined(AVX2)
+#define KERNELS_AVX2
+#endif
+#if defined(AVX512)
+#define KERNELS_AVX512
+#endif
+#if defined(VNNI512)
+#define KERNELS_VNNI512
+#endif
+#define TARGET_AVX2
+#define TARGET_AVX512
+#define TARGET_VNNI512
+#endif
+
 using Score = int32_t;
 using Depth = int8_t;
 using Ply = int8_t;
@@ -0,0 +1,150 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../utils/utilities.h"
+#include "castling_rights.h"
+
+#include <charconv>
+#include <string>
+#include <string_view>
+
+namespace chess {
+
+    // 71 characters of piece placement, the side to move, castling rights, en passant square and a 10 digit move counter
+    constexpr size_t FEN_MAX_LENGTH = 96;
+
+    // The fields of a FEN string, the full move counter is not used.
+    struct Fen {
+        Piece mailbox[64];
+        Color stm = WHITE;
+        CastlingRights rights;
+        Square ep = NULL_SQUARE;
+        unsigned int move50 = 0;
+    };
+
+    // Removes and returns the next whitespace separated field, which is empty after the last field.
+    constexpr std::string_view next_fen_field(std::string_view &str) {
+        constexpr std::string_view WHITESPACE = " \t\r\n";
+        const size_t begin = std::min(str.find_first_not_of(WHITESPACE), str.size());
+        const size_t end = std::min(str.find_first_of(WHITESPACE, begin), str.size());
+        const std::string_view field = str.substr(begin, end - begin);
+        str.remove_prefix(end);
+        return field;
+    }
+
+    // Parses a FEN string in a single pass without allocating. The piece placement and the side to move are always
+    // checked, in strict mode the castling rights, the en passant square and the 50-move counter have to be well-formed too.
+    // Otherwise the missing or malformed optional fields fall back to their defaults, like in abbreviated EPD positions.
+    // Returns false if the string is not a valid FEN.
+    bool parse_fen(std::string_view str, Fen &fen, bool strict) {
+        fen = Fen();
+
+        unsigned int rank = 7, file = 0;
+        for (char c : next_fen_field(str)) {
+            if (c == '/') {
+                if (file != 8 || rank == 0) return false;
+                rank--;
+                file = 0;
+            } else if ('1' <= c && c <= '8') {
+                file += c - '0';
+                if (file > 8) return false;
+            } else {
+                const Piece piece = static_cast<unsigned char>(c) < 128 ? piece_from_char(c) : NULL_PIECE;
+                if (piece.is_null() || file >= 8) return false;
+                fen.mailbox[rank * 8 + file++] = piece;
+            }
+        }
+        if (rank != 0 || file != 8) return false;
+
+        const std::string_view stm = next_fen_field(str);
+        if (stm == "w") {
+            fen.stm = WHITE;
+        } else if (stm == "b") {
+            fen.stm = BLACK;
+        } else {
+            return false;
+        }
+
+        const std::string_view rights = next_fen_field(str);
+        if (strict && rights.empty()) return false;
+        if (rights != "-") {
+            for (char c : rights) {
+                const unsigned int right = CastlingRights::from_char(c);
+                if (strict && right == 0) return false;
+                fen.rights += right;
+            }
+        }
+
+        const std::string_view ep = next_fen_field(str);
+        if (strict && ep.empty()) return false;
+        if (!ep.empty() && ep != "-") {
+            if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || ep[1] < '1' || ep[1] > '8') return false;
+            if (strict && ep[1] != '3' && ep[1] != '6') return false;
+            fen.ep = Square((ep[0] - 'a') + (ep[1] - '1') * 8);
+        }
+
+        const std::string_view move50 = next_fen_field(str);
+        const auto [end, error] = std::from_chars(move50.data(), move50.data() + move50.size(), fen.move50);
+        if (move50.empty() || error != std::errc() || end != move50.data() + move50.size()) {
+            if (strict) return false;
+            fen.move50 = 0;
+        }
+
+        return true;
+    }
+
+    // Writes the FEN into out, which needs room for FEN_MAX_LENGTH characters. Returns the end of the written characters.
+    char *write_fen(const Fen &fen, char *out) {
+        for (int rank = 7; rank >= 0; rank--) {
+            char empty = 0;
+            for (int file = 0; file < 8; file++) {
+                const Piece piece = fen.mailbox[rank * 8 + file];
+                if (piece.is_null()) {
+                    empty++;
+                    continue;
+                }
+                if (empty) *out++ = char('0' + empty);
+                *out++ = char_from_piece(piece);
+                empty = 0;
+            }
+            if (empty) *out++ = char('0' + empty);
+            if (rank != 0) *out++ = '/';
+        }
+
+        *out++ = ' ';
+        *out++ = fen.stm == WHITE ? 'w' : 'b';
+        *out++ = ' ';
+        out = fen.rights.write(out);
+        *out++ = ' ';
+        if (fen.ep == NULL_SQUARE) {
+            *out++ = '-';
+        } else {
+            *out++ = char('a' + square_to_file(fen.ep));
+            *out++ = char('1' + fen.ep / 8);
+        }
+        *out++ = ' ';
+        return std::to_chars(out, out + 10, fen.move50).ptr;
+    }
+
+    std::string write_fen(const Fen &fen) {
+        char buffer[FEN_MAX_LENGTH];
+        return std::string(buffer, write_fen(fen, buffer));
+    }
+
+} // namespace chess
@@ -0,0 +1,98 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "bitboard.h"
+
+#include <immintrin.h>
+
+#if defined(KOGGE_STONE) && (!defined(AVX2) || defined(DISPATCH))
+#error "Kogge-Stone sliding attacks require an AVX2 build"
+#endif
+
+// Sliding attacks calculated with Kogge-Stone occluded fills instead of looked up in the magic tables.
+// The 4 directions of a rook or a bishop are filled at once, one in each 64-bit lane of an AVX2 register.
+// Selected at build time with KOGGE_STONE, and also compiled into dispatch builds for the slider benchmark.
+namespace chess::kogge_stone {
+#ifdef KERNELS_AVX2
+
+    // The directions of a piece, every lane either shifts left or right. Variable shifts by 64 clear the lane,
+    // so shifting by both the left and the right amounts and combining them steps every lane in its own direction.
+    struct Directions {
+        __m256i left, right;
+        // The squares that a single step can reach without wrapping around the board
+        __m256i wrap;
+    };
+
+    // North, east, south and west
+    TARGET_AVX2 inline Directions rook_directions() {
+        return {_mm256_setr_epi64x(8, 1, 64, 64), _mm256_setr_epi64x(64, 64, 8, 1),
+                _mm256_setr_epi64x(-1, int64_t(NOT_FILE_A.bb), -1, int64_t(NOT_FILE_H.bb))};
+    }
+
+    // North-east, north-west, south-west and south-east
+    TARGET_AVX2 inline Directions bishop_directions() {
+        return {_mm256_setr_epi64x(9, 7, 64, 64), _mm256_setr_epi64x(64, 64, 9, 7),
+                _mm256_setr_epi64x(int64_t(NOT_FILE_A.bb), int64_t(NOT_FILE_H.bb), int64_t(NOT_FILE_H.bb), int64_t(NOT_FILE_A.bb))};
+    }
+
+    TARGET_AVX2 inline __m256i shift(__m256i x, __m256i left, __m256i right) {
+        return _mm256_or_si256(_mm256_sllv_epi64(x, left), _mm256_srlv_epi64(x, right));
+    }
+
+    // Returns the attacks of a slider on square along the 4 directions, in separate lanes.
+    TARGET_AVX2 inline __m256i attacks4(Square square, Bitboard occupied, const Directions &dirs) {
+        __m256i gen = _mm256_set1_epi64x(int64_t(1ULL << square));
+        __m256i pro = _mm256_andnot_si256(_mm256_set1_epi64x(int64_t(occupied.bb)), dirs.wrap);
+        __m256i left = dirs.left, right = dirs.right;
+
+        // Fills 1, 2 and 4 steps further each time, through the empty squares only
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift(gen, left, right)));
+        pro = _mm256_and_si256(pro, shift(pro, left, right));
+        left = _mm256_add_epi64(left, left);
+        right = _mm256_add_epi64(right, right);
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift(gen, left, right)));
+        pro = _mm256_and_si256(pro, shift(pro, left, right));
+        left = _mm256_add_epi64(left, left);
+        right = _mm256_add_epi64(right, right);
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift(gen, left, right)));
+
+        // The attacks are one more step from the filled squares, which includes the first blocker
+        return _mm256_and_si256(shift(gen, dirs.left, dirs.right), dirs.wrap);
+    }
+
+    TARGET_AVX2 inline Bitboard reduce_or(__m256i attacks) {
+        __m128i result = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+        result = _mm_or_si128(result, _mm_unpackhi_epi64(result, result));
+        return uint64_t(_mm_cvtsi128_si64(result));
+    }
+
+    TARGET_AVX2 inline Bitboard attacks_rook(Square square, Bitboard occupied) {
+        return reduce_or(attacks4(square, occupied, rook_directions()));
+    }
+
+    TARGET_AVX2 inline Bitboard attacks_bishop(Square square, Bitboard occupied) {
+        return reduce_or(attacks4(square, occupied, bishop_directions()));
+    }
+
+    TARGET_AVX2 inline Bitboard attacks_queen(Square square, Bitboard occupied) {
+        return reduce_or(_mm256_or_si256(attacks4(square, occupied, rook_directions()), attacks4(square, occupied, bishop_directions())));
+    }
+
+#endif
+} // namespace chess::kogge_stone
@@ -17,21 +17,20 @@
 
 #pragma once
 
+#include "../utils/cpu.h"
 #include "../utils/utilities.h"
 #include "bitboard.h"
+#include "masks.h"
 
 namespace chess {
-    // Stores a magic entry.
+    // Stores a magic entry, the attacks of its square start at offset in the lookup table of the piece.
     struct Magic {
-        Bitboard *ptr;
+        unsigned int offset;
         Bitboard mask;
         Bitboard magic;
         unsigned int shift;
     };
 
-    extern Bitboard attack_table_rook[102400];
-    extern Bitboard attack_table_bishop[5248];
-
     // Slow naive function of getting the attacked squares of a sliding piece.
     [[nodiscard]] Bitboard attacks_sliding_slow(Square square, Bitboard occupied, PieceType pt) {
         assert((pt == ROOK) || (pt == BISHOP));
@@ -47,182 +46,251 @@ namespace chess {
         }
     }
 
-    // Converts the magic and the occupancy bitboard into an index in the lookup table.
-    [[nodiscard]] unsigned int get_magic_index(const Magic &m, Bitboard occ) {
-#ifdef BMI2
-        return _pext_u64(occ.bb, m.mask.bb);
+    // Whether the lookup tables are indexed by PEXT or by multiplying with the magic number.
+    // Selected once at startup in dispatch builds, which contain the tables of both layouts.
+#if defined(DISPATCH)
+    bool use_pext = false;
+#elif defined(BMI2)
+    constexpr bool use_pext = true;
 #else
-        return (((occ & m.mask) * m.magic) >> (64 - m.shift)).bb;
+    constexpr bool use_pext = false;
 #endif
-    }
-
-    // Initializes magic bitboards by pt.
-    void init_magic(const Magic *magics, PieceType pt) {
-        assert((pt == ROOK) || (pt == BISHOP));
-        Bitboard occupied[4096], attacked[4096];
 
-        for (Square square = A1; square < 64; square += 1) {
-            const Magic &magic = magics[square];
-
-            size_t length = 0;
-            Bitboard occ = 0;
-            do {
-                occupied[length] = occ;
-                attacked[length] = attacks_sliding_slow(square, occ, pt);
-
-                length++;
-                occ = (occ - magic.mask) & magic.mask;
-            } while (occ != 0);
+    void select_magic_index(const cpu::Features &features) {
+#ifdef DISPATCH
+        use_pext = features.fast_pext;
+#endif
+    }
 
-            for (size_t i = 0; i < length; i++) {
-                uint64_t index = get_magic_index(magic, occupied[i]);
+    [[nodiscard]] const char *get_magic_index_name() {
+        return use_pext ? "pext" : "multiply";
+    }
 
-                magic.ptr[index] = attacked[i];
-            }
-        }
+    // Converts the magic and the occupancy bitboard into an index in the lookup table by multiplying with the magic number.
+    [[nodiscard]] constexpr unsigned int get_multiply_index(const Magic &m, Bitboard occ) {
+        return (((occ & m.mask) * m.magic) >> (64 - m.shift)).bb;
     }
 
     /*
  * Fancy magic bitboards
- * To generate the attackTables from them use initMagic
+ * The attack tables are generated from them at compile time by generate_attack_table
  * To generate new magic numbers use findMagics
  */
     constexpr Magic magic_rook[64] = {
-            {attack_table_rook + 0, 0x101010101017eULL, 0x200102084420100ULL, 12},
-            {attack_table_rook + 4096, 0x202020202027cULL, 0x40200040001000ULL, 11},
-            {attack_table_rook + 6144, 0x404040404047aULL, 0x4100082000104300ULL, 11},
-            {attack_table_rook + 8192, 0x8080808080876ULL, 0x480049000080080ULL, 11},
-            {attack_table_rook + 10240, 0x1010101010106eULL, 0x100040211000800ULL, 11},
-            {attack_table_rook + 12288, 0x2020202020205eULL, 0x2500240002080100ULL, 11},
-            {attack_table_rook + 14336, 0x4040404040403eULL, 0x280120001000080ULL, 11},
-            {attack_table_rook + 16384, 0x8080808080807eULL, 0x200004086002b04ULL, 12},
-            {attack_table_rook + 20480, 0x1010101017e00ULL, 0x401800280400020ULL, 11},
-            {attack_table_rook + 22528, 0x2020202027c00ULL, 0x8601400050002000ULL, 10},
-            {attack_table_rook + 23552, 0x4040404047a00ULL, 0x802801000200280ULL, 10},
-            {attack_table_rook + 24576, 0x8080808087600ULL, 0x411001001002008ULL, 10},
-            {attack_table_rook + 25600, 0x10101010106e00ULL, 0x11000410080300ULL, 10},
-            {attack_table_rook + 26624, 0x20202020205e00ULL, 0x20a000804108200ULL, 10},
-            {attack_table_rook + 27648, 0x40404040403e00ULL, 0x84006850240102ULL, 10},
-            {attack_table_rook + 28672, 0x80808080807e00ULL, 0x24800049000080ULL, 11},
-            {attack_table_rook + 30720, 0x10101017e0100ULL, 0x208000400080ULL, 11},
-            {attack_table_rook + 32768, 0x20202027c0200ULL, 0x101020020804202ULL, 10},
-            {attack_table_rook + 33792, 0x40404047a0400ULL, 0x20828010022000ULL, 10},
-            {attack_table_rook + 34816, 0x8080808760800ULL, 0x801230009001000ULL, 10},
-            {attack_table_rook + 35840, 0x101010106e1000ULL, 0x5608808004020801ULL, 10},
-            {attack_table_rook + 36864, 0x202020205e2000ULL, 0x3086008080040002ULL, 10},
-            {attack_table_rook + 37888, 0x404040403e4000ULL, 0x40041221008ULL, 10},
-            {attack_table_rook + 38912, 0x808080807e8000ULL, 0x8000020000811044ULL, 11},
-            {attack_table_rook + 40960, 0x101017e010100ULL, 0x21c00180002081ULL, 11},
-            {attack_table_rook + 43008, 0x202027c020200ULL, 0xa010024140002000ULL, 10},
-            {attack_table_rook + 44032, 0x404047a040400ULL, 0x1040200280100080ULL, 10},
-            {attack_table_rook + 45056, 0x8080876080800ULL, 0x2100100200b00ULL, 10},
-            {attack_table_rook + 46080, 0x1010106e101000ULL, 0x8014008080040800ULL, 10},
-            {attack_table_rook + 47104, 0x2020205e202000ULL, 0x840200120008904cULL, 10},
-            {attack_table_rook + 48128, 0x4040403e404000ULL, 0x10020400811058ULL, 10},
-            {attack_table_rook + 49152, 0x8080807e808000ULL, 0x8280040200004081ULL, 11},
-            {attack_table_rook + 51200, 0x1017e01010100ULL, 0xa000408001002100ULL, 11},
-            {attack_table_rook + 53248, 0x2027c02020200ULL, 0x210904000802000ULL, 10},
-            {attack_table_rook + 54272, 0x4047a04040400ULL, 0x200204082001200ULL, 10},
-            {attack_table_rook + 55296, 0x8087608080800ULL, 0x2204201042000a00ULL, 10},
-            {attack_table_rook + 56320, 0x10106e10101000ULL, 0x6c80040801001100ULL, 10},
-            {attack_table_rook + 57344, 0x20205e20202000ULL, 0x8040080800200ULL, 10},
-            {attack_table_rook + 58368, 0x40403e40404000ULL, 0x2b0900804001663ULL, 10},
-            {attack_table_rook + 59392, 0x80807e80808000ULL, 0x4074800040800100ULL, 11},
-            {attack_table_rook + 61440, 0x17e0101010100ULL, 0x4000400080208000ULL, 11},
-            {attack_table_rook + 63488, 0x27c0202020200ULL, 0x1a40500020004001ULL, 10},
-            {attack_table_rook + 64512, 0x47a0404040400ULL, 0x1004020010018ULL, 10},
-            {attack_table_rook + 65536, 0x8760808080800ULL, 0x20201200420008ULL, 10},
-            {attack_table_rook + 66560, 0x106e1010101000ULL, 0xc24008008008005ULL, 10},
-            {attack_table_rook + 67584, 0x205e2020202000ULL, 0x4002010804020010ULL, 10},
-            {attack_table_rook + 68608, 0x403e4040404000ULL, 0xb015081002040001ULL, 10},
-            {attack_table_rook + 69632, 0x807e8080808000ULL, 0x4000408c020029ULL, 11},
-            {attack_table_rook + 71680, 0x7e010101010100ULL, 0xb840004020800080ULL, 11},
-            {attack_table_rook + 73728, 0x7c020202020200ULL, 0x60804001002100ULL, 10},
-            {attack_table_rook + 74752, 0x7a040404040400ULL, 0x210810a285420200ULL, 10},
-            {attack_table_rook + 75776, 0x76080808080800ULL, 0xa000080010008080ULL, 10},
-            {attack_table_rook + 76800, 0x6e101010101000ULL, 0x800050010080100ULL, 10},
-            {attack_table_rook + 77824, 0x5e202020202000ULL, 0x4040002008080ULL, 10},
-            {attack_table_rook + 78848, 0x3e404040404000ULL, 0x80b4011042080400ULL, 10},
-            {attack_table_rook + 79872, 0x7e808080808000ULL, 0x6014004114008200ULL, 11},
-            {attack_table_rook + 81920, 0x7e01010101010100ULL, 0x1001002018408202ULL, 12},
-            {attack_table_rook + 86016, 0x7c02020202020200ULL, 0x2400104128421ULL, 11},
-            {attack_table_rook + 88064, 0x7a04040404040400ULL, 0x407600010408901ULL, 11},
-            {attack_table_rook + 90112, 0x7608080808080800ULL, 0x108448a01001000dULL, 11},
-            {attack_table_rook + 92160, 0x6e10101010101000ULL, 0x8402011008842002ULL, 11},
-            {attack_table_rook + 94208, 0x5e20202020202000ULL, 0x11000204000801ULL, 11},
-            {attack_table_rook + 96256, 0x3e40404040404000ULL, 0x4026000108208452ULL, 11},
-            {attack_table_rook + 98304, 0x7e80808080808000ULL, 0x800081004c2c06ULL, 12},
+            {0, 0x101010101017eULL, 0x200102084420100ULL, 12},
+            {4096, 0x202020202027cULL, 0x40200040001000ULL, 11},
+            {6144, 0x404040404047aULL, 0x4100082000104300ULL, 11},
+            {8192, 0x8080808080876ULL, 0x480049000080080ULL, 11},
+            {10240, 0x1010101010106eULL, 0x100040211000800ULL, 11},
+            {12288, 0x2020202020205eULL, 0x2500240002080100ULL, 11},
+            {14336, 0x4040404040403eULL, 0x280120001000080ULL, 11},
+            {16384, 0x8080808080807eULL, 0x200004086002b04ULL, 12},
+            {20480, 0x1010101017e00ULL, 0x401800280400020ULL, 11},
+            {22528, 0x2020202027c00ULL, 0x8601400050002000ULL, 10},
+            {23552, 0x4040404047a00ULL, 0x802801000200280ULL, 10},
+            {24576, 0x8080808087600ULL, 0x411001001002008ULL, 10},
+            {25600, 0x10101010106e00ULL, 0x11000410080300ULL, 10},
+            {26624, 0x20202020205e00ULL, 0x20a000804108200ULL, 10},
+            {27648, 0x40404040403e00ULL, 0x84006850240102ULL, 10},
+            {28672, 0x80808080807e00ULL, 0x24800049000080ULL, 11},
+            {30720, 0x10101017e0100ULL, 0x208000400080ULL, 11},
+            {32768, 0x20202027c0200ULL, 0x101020020804202ULL, 10},
+            {33792, 0x40404047a0400ULL, 0x20828010022000ULL, 10},
+            {34816, 0x8080808760800ULL, 0x801230009001000ULL, 10},
+            {35840, 0x101010106e1000ULL, 0x5608808004020801ULL, 10},
+            {36864, 0x202020205e2000ULL, 0x3086008080040002ULL, 10},
+            {37888, 0x404040403e4000ULL, 0x40041221008ULL, 10},
+            {38912, 0x808080807e8000ULL, 0x8000020000811044ULL, 11},
+            {40960, 0x101017e010100ULL, 0x21c00180002081ULL, 11},
+            {43008, 0x202027c020200ULL, 0xa010024140002000ULL, 10},
+            {44032, 0x404047a040400ULL, 0x1040200280100080ULL, 10},
+            {45056, 0x8080876080800ULL, 0x2100100200b00ULL, 10},
+            {46080, 0x1010106e101000ULL, 0x8014008080040800ULL, 10},
+            {47104, 0x2020205e202000ULL, 0x840200120008904cULL, 10},
+            {48128, 0x4040403e404000ULL, 0x10020400811058ULL, 10},
+            {49152, 0x8080807e808000ULL, 0x8280040200004081ULL, 11},
+            {51200, 0x1017e01010100ULL, 0xa000408001002100ULL, 11},
+            {53248, 0x2027c02020200ULL, 0x210904000802000ULL, 10},
+            {54272, 0x4047a04040400ULL, 0x200204082001200ULL, 10},
+            {55296, 0x8087608080800ULL, 0x2204201042000a00ULL, 10},
+            {56320, 0x10106e10101000ULL, 0x6c80040801001100ULL, 10},
+            {57344, 0x20205e20202000ULL, 0x8040080800200ULL, 10},
+            {58368, 0x40403e40404000ULL, 0x2b0900804001663ULL, 10},
+            {59392, 0x80807e80808000ULL, 0x4074800040800100ULL, 11},
+            {61440, 0x17e0101010100ULL, 0x4000400080208000ULL, 11},
+            {63488, 0x27c0202020200ULL, 0x1a40500020004001ULL, 10},
+            {64512, 0x47a0404040400ULL, 0x1004020010018ULL, 10},
+            {65536, 0x8760808080800ULL, 0x20201200420008ULL, 10},
+            {66560, 0x106e1010101000ULL, 0xc24008008008005ULL, 10},
+            {67584, 0x205e2020202000ULL, 0x4002010804020010ULL, 10},
+            {68608, 0x403e4040404000ULL, 0xb015081002040001ULL, 10},
+            {69632, 0x807e8080808000ULL, 0x4000408c020029ULL, 11},
+            {71680, 0x7e010101010100ULL, 0xb840004020800080ULL, 11},
+            {73728, 0x7c020202020200ULL, 0x60804001002100ULL, 10},
+            {74752, 0x7a040404040400ULL, 0x210810a285420200ULL, 10},
+            {75776, 0x76080808080800ULL, 0xa000080010008080ULL, 10},
+            {76800, 0x6e101010101000ULL, 0x800050010080100ULL, 10},
+            {77824, 0x5e202020202000ULL, 0x4040002008080ULL, 10},
+            {78848, 0x3e404040404000ULL, 0x80b4011042080400ULL, 10},
+            {79872, 0x7e808080808000ULL, 0x6014004114008200ULL, 11},
+            {81920, 0x7e01010101010100ULL, 0x1001002018408202ULL, 12},
+            {86016, 0x7c02020202020200ULL, 0x2400104128421ULL, 11},
+            {88064, 0x7a04040404040400ULL, 0x407600010408901ULL, 11},
+            {90112, 0x7608080808080800ULL, 0x108448a01001000dULL, 11},
+            {92160, 0x6e10101010101000ULL, 0x8402011008842002ULL, 11},
+            {94208, 0x5e20202020202000ULL, 0x11000204000801ULL, 11},
+            {96256, 0x3e40404040404000ULL, 0x4026000108208452ULL, 11},
+            {98304, 0x7e80808080808000ULL, 0x800081004c2c06ULL, 12},
     };
 
     constexpr Magic magic_bishop[64] = {
-            {attack_table_bishop + 0, 0x40201008040200ULL, 0x4100216240212ULL, 6},
-            {attack_table_bishop + 64, 0x402010080400ULL, 0x8080110420002ULL, 5},
-            {attack_table_bishop + 96, 0x4020100a00ULL, 0x4280091000005ULL, 5},
-            {attack_table_bishop + 128, 0x40221400ULL, 0x24410020801400ULL, 5},
-            {attack_table_bishop + 160, 0x2442800ULL, 0x4242000000311ULL, 5},
-            {attack_table_bishop + 192, 0x204085000ULL, 0x882021006148000ULL, 5},
-            {attack_table_bishop + 224, 0x20408102000ULL, 0xb440a0210260800ULL, 5},
-            {attack_table_bishop + 256, 0x2040810204000ULL, 0x80840c0a011c00ULL, 6},
-            {attack_table_bishop + 320, 0x20100804020000ULL, 0x1000040488080100ULL, 5},
-            {attack_table_bishop + 352, 0x40201008040000ULL, 0x800a200202284112ULL, 5},
-            {attack_table_bishop + 384, 0x4020100a0000ULL, 0xcc00098401020000ULL, 5},
-            {attack_table_bishop + 416, 0x4022140000ULL, 0x8000080a00202000ULL, 5},
-            {attack_table_bishop + 448, 0x244280000ULL, 0x8821210000824ULL, 5},
-            {attack_table_bishop + 480, 0x20408500000ULL, 0xc000088230400020ULL, 5},
-            {attack_table_bishop + 512, 0x2040810200000ULL, 0x2904494808a41024ULL, 5},
-            {attack_table_bishop + 544, 0x4081020400000ULL, 0x2302882301004ULL, 5},
-            {attack_table_bishop + 576, 0x10080402000200ULL, 0x910200610100104ULL, 5},
-            {attack_table_bishop + 608, 0x20100804000400ULL, 0x910800850008080ULL, 5},
-            {attack_table_bishop + 640, 0x4020100a000a00ULL, 0x30080010004d4009ULL, 7},
-            {attack_table_bishop + 768, 0x402214001400ULL, 0x4108000c20222001ULL, 7},
-            {attack_table_bishop + 896, 0x24428002800ULL, 0x22000400942005ULL, 7},
-            {attack_table_bishop + 1024, 0x2040850005000ULL, 0xa021100512400ULL, 7},
-            {attack_table_bishop + 1152, 0x4081020002000ULL, 0xa001000041301024ULL, 5},
-            {attack_table_bishop + 1184, 0x8102040004000ULL, 0x8000420206021981ULL, 5},
-            {attack_table_bishop + 1216, 0x8040200020400ULL, 0x1008480004606800ULL, 5},
-            {attack_table_bishop + 1248, 0x10080400040800ULL, 0x4a8280003100100ULL, 5},
-            {attack_table_bishop + 1280, 0x20100a000a1000ULL, 0x3480010182240ULL, 7},
-            {attack_table_bishop + 1408, 0x40221400142200ULL, 0x2048080102820042ULL, 9},
-            {attack_table_bishop + 1920, 0x2442800284400ULL, 0x4001020004008400ULL, 9},
-            {attack_table_bishop + 2432, 0x4085000500800ULL, 0x204004048080200ULL, 7},
-            {attack_table_bishop + 2560, 0x8102000201000ULL, 0x2008200040212a0ULL, 5},
-            {attack_table_bishop + 2592, 0x10204000402000ULL, 0x10c013002430400ULL, 5},
-            {attack_table_bishop + 2624, 0x4020002040800ULL, 0x4300a5082214480ULL, 5},
-            {attack_table_bishop + 2656, 0x8040004081000ULL, 0x401041000215900ULL, 5},
-            {attack_table_bishop + 2688, 0x100a000a102000ULL, 0x104804048040408ULL, 7},
-            {attack_table_bishop + 2816, 0x22140014224000ULL, 0x800400808208200ULL, 9},
-            {attack_table_bishop + 3328, 0x44280028440200ULL, 0x8002400054101ULL, 9},
-            {attack_table_bishop + 3840, 0x8500050080400ULL, 0x2001004502020102ULL, 7},
-            {attack_table_bishop + 3968, 0x10200020100800ULL, 0x1988080110006100ULL, 5},
-            {attack_table_bishop + 4000, 0x20400040201000ULL, 0x1282009200102201ULL, 5},
-            {attack_table_bishop + 4032, 0x2000204081000ULL, 0xa208010420001280ULL, 5},
-            {attack_table_bishop + 4064, 0x4000408102000ULL, 0x4004010809000200ULL, 5},
-            {attack_table_bishop + 4096, 0xa000a10204000ULL, 0x43008150006100ULL, 7},
-            {attack_table_bishop + 4224, 0x14001422400000ULL, 0x2410145000801ULL, 7},
-            {attack_table_bishop + 4352, 0x28002844020000ULL, 0x280104006040ULL, 7},
-            {attack_table_bishop + 4480, 0x50005008040200ULL, 0x4012042000902ULL, 7},
-            {attack_table_bishop + 4608, 0x20002010080400ULL, 0x28100482080a82ULL, 5},
-            {attack_table_bishop + 4640, 0x40004020100800ULL, 0x80040c2400240240ULL, 5},
-            {attack_table_bishop + 4672, 0x20408102000ULL, 0x80c1101101044a0ULL, 5},
-            {attack_table_bishop + 4704, 0x40810204000ULL, 0x180804802310808ULL, 5},
-            {attack_table_bishop + 4736, 0xa1020400000ULL, 0x8048080064ULL, 5},
-            {attack_table_bishop + 4768, 0x142240000000ULL, 0x8c8400020880000ULL, 5},
-            {attack_table_bishop + 4800, 0x284402000000ULL, 0x30001010020a2000ULL, 5},
-            {attack_table_bishop + 4832, 0x500804020000ULL, 0x80600282220010ULL, 5},
-            {attack_table_bishop + 4864, 0x201008040200ULL, 0x120228228010000ULL, 5},
-            {attack_table_bishop + 4896, 0x402010080400ULL, 0xc08020802042300ULL, 5},
-            {attack_table_bishop + 4928, 0x2040810204000ULL, 0x2a008048221000ULL, 6},
-            {attack_table_bishop + 4992, 0x4081020400000ULL, 0x4601204100901002ULL, 5},
-            {attack_table_bishop + 5024, 0xa102040000000ULL, 0x821200104052400ULL, 5},
-            {attack_table_bishop + 5056, 0x14224000000000ULL, 0x8200084208810ULL, 5},
-            {attack_table_bishop + 5088, 0x28440200000000ULL, 0x8c022040a80b0408ULL, 5},
-            {attack_table_bishop + 5120, 0x50080402000000ULL, 0x2140201012100512ULL, 5},
-            {attack_table_bishop + 5152, 0x20100804020000ULL, 0x10210240128120aULL, 5},
-            {attack_table_bishop + 5184, 0x40201008040200ULL, 0x208600082060020ULL, 6},
+            {0, 0x40201008040200ULL, 0x4100216240212ULL, 6},
+            {64, 0x402010080400ULL, 0x8080110420002ULL, 5},
+            {96, 0x4020100a00ULL, 0x4280091000005ULL, 5},
+            {128, 0x40221400ULL, 0x24410020801400ULL, 5},
+            {160, 0x2442800ULL, 0x4242000000311ULL, 5},
+            {192, 0x204085000ULL, 0x882021006148000ULL, 5},
+            {224, 0x20408102000ULL, 0xb440a0210260800ULL, 5},
+            {256, 0x2040810204000ULL, 0x80840c0a011c00ULL, 6},
+            {320, 0x20100804020000ULL, 0x1000040488080100ULL, 5},
+            {352, 0x40201008040000ULL, 0x800a200202284112ULL, 5},
+            {384, 0x4020100a0000ULL, 0xcc00098401020000ULL, 5},
+            {416, 0x4022140000ULL, 0x8000080a00202000ULL, 5},
+            {448, 0x244280000ULL, 0x8821210000824ULL, 5},
+            {480, 0x20408500000ULL, 0xc000088230400020ULL, 5},
+            {512, 0x2040810200000ULL, 0x2904494808a41024ULL, 5},
+            {544, 0x4081020400000ULL, 0x2302882301004ULL, 5},
+            {576, 0x10080402000200ULL, 0x910200610100104ULL, 5},
+            {608, 0x20100804000400ULL, 0x910800850008080ULL, 5},
+            {640, 0x4020100a000a00ULL, 0x30080010004d4009ULL, 7},
+            {768, 0x402214001400ULL, 0x4108000c20222001ULL, 7},
+            {896, 0x24428002800ULL, 0x22000400942005ULL, 7},
+            {1024, 0x2040850005000ULL, 0xa021100512400ULL, 7},
+            {1152, 0x4081020002000ULL, 0xa001000041301024ULL, 5},
+            {1184, 0x8102040004000ULL, 0x8000420206021981ULL, 5},
+            {1216, 0x8040200020400ULL, 0x1008480004606800ULL, 5},
+            {1248, 0x10080400040800ULL, 0x4a8280003100100ULL, 5},
+            {1280, 0x20100a000a1000ULL, 0x3480010182240ULL, 7},
+            {1408, 0x40221400142200ULL, 0x2048080102820042ULL, 9},
+            {1920, 0x2442800284400ULL, 0x4001020004008400ULL, 9},
+            {2432, 0x4085000500800ULL, 0x204004048080200ULL, 7},
+            {2560, 0x8102000201000ULL, 0x2008200040212a0ULL, 5},
+            {2592, 0x10204000402000ULL, 0x10c013002430400ULL, 5},
+            {2624, 0x4020002040800ULL, 0x4300a5082214480ULL, 5},
+            {2656, 0x8040004081000ULL, 0x401041000215900ULL, 5},
+            {2688, 0x100a000a102000ULL, 0x104804048040408ULL, 7},
+            {2816, 0x22140014224000ULL, 0x800400808208200ULL, 9},
+            {3328, 0x44280028440200ULL, 0x8002400054101ULL, 9},
+            {3840, 0x8500050080400ULL, 0x2001004502020102ULL, 7},
+            {3968, 0x10200020100800ULL, 0x1988080110006100ULL, 5},
+            {4000, 0x20400040201000ULL, 0x1282009200102201ULL, 5},
+            {4032, 0x2000204081000ULL, 0xa208010420001280ULL, 5},
+            {4064, 0x4000408102000ULL, 0x4004010809000200ULL, 5},
+            {4096, 0xa000a10204000ULL, 0x43008150006100ULL, 7},
+            {4224, 0x14001422400000ULL, 0x2410145000801ULL, 7},
+            {4352, 0x28002844020000ULL, 0x280104006040ULL, 7},
+            {4480, 0x50005008040200ULL, 0x4012042000902ULL, 7},
+            {4608, 0x20002010080400ULL, 0x28100482080a82ULL, 5},
+            {4640, 0x40004020100800ULL, 0x80040c2400240240ULL, 5},
+            {4672, 0x20408102000ULL, 0x80c1101101044a0ULL, 5},
+            {4704, 0x40810204000ULL, 0x180804802310808ULL, 5},
+            {4736, 0xa1020400000ULL, 0x8048080064ULL, 5},
+            {4768, 0x142240000000ULL, 0x8c8400020880000ULL, 5},
+            {4800, 0x284402000000ULL, 0x30001010020a2000ULL, 5},
+            {4832, 0x500804020000ULL, 0x80600282220010ULL, 5},
+            {4864, 0x201008040200ULL, 0x120228228010000ULL, 5},
+            {4896, 0x402010080400ULL, 0xc08020802042300ULL, 5},
+            {4928, 0x2040810204000ULL, 0x2a008048221000ULL, 6},
+            {4992, 0x4081020400000ULL, 0x4601204100901002ULL, 5},
+            {5024, 0xa102040000000ULL, 0x821200104052400ULL, 5},
+            {5056, 0x14224000000000ULL, 0x8200084208810ULL, 5},
+            {5088, 0x28440200000000ULL, 0x8c022040a80b0408ULL, 5},
+            {5120, 0x50080402000000ULL, 0x2140201012100512ULL, 5},
+            {5152, 0x20100804020000ULL, 0x10210240128120aULL, 5},
+            {5184, 0x40201008040200ULL, 0x208600082060020ULL, 6},
     };
 
-    void init_magic() {
-        init_magic(magic_rook, ROOK);
-        init_magic(magic_bishop, BISHOP);
+    template<PieceType pt>
+    constexpr size_t ATTACK_TABLE_SIZE = pt == ROOK ? 102400 : 5248;
+
+    template<size_t N>
+    struct AttackTable {
+        Bitboard attacks[N];
+    };
+
+    // Generates the lookup table of pt, indexed by PEXT or by multiplying with the magic number.
+    // The occupancies of a square are enumerated by counting through the subsets of its mask,
+    // so their PEXT index is the number of occupancies before them.
+    // Compile time evaluation is slow, so the loop works on plain integers.
+    template<PieceType pt, bool pext>
+    [[nodiscard]] constexpr AttackTable<ATTACK_TABLE_SIZE<pt>> generate_attack_table() {
+        static_assert((pt == ROOK) || (pt == BISHOP));
+        // The indices of the directions of the piece in DIRECTIONS, the first two go towards higher squares.
+        constexpr unsigned int dirs[4] = {pt == ROOK ? 0u : 2u, pt == ROOK ? 5u : 3u, pt == ROOK ? 1u : 6u, pt == ROOK ? 4u : 7u};
+        const Magic *magics = pt == ROOK ? magic_rook : magic_bishop;
+        AttackTable<ATTACK_TABLE_SIZE<pt>> table{};
+
+        for (Square square = A1; square < 64; square += 1) {
+            const uint64_t mask = magics[square].mask.bb, magic = magics[square].magic.bb;
+            const unsigned int offset = magics[square].offset, shift = magics[square].shift;
+
+            uint64_t rays[4] = {}, all_rays = 0;
+            for (unsigned int i = 0; i < 4; i++) {
+                rays[i] = masks_ray[dirs[i]][square].bb;
+                all_rays |= rays[i];
+            }
+
+            unsigned int length = 0;
+            uint64_t occ = 0;
+            do {
+                uint64_t attacks = all_rays, blockers;
+                if ((blockers = rays[0] & occ)) attacks ^= masks_ray[dirs[0]][std::countr_zero(blockers)].bb;
+                if ((blockers = rays[1] & occ)) attacks ^= masks_ray[dirs[1]][std::countr_zero(blockers)].bb;
+                if ((blockers = rays[2] & occ)) attacks ^= masks_ray[dirs[2]][63 - std::countl_zero(blockers)].bb;
+                if ((blockers = rays[3] & occ)) attacks ^= masks_ray[dirs[3]][63 - std::countl_zero(blockers)].bb;
+                table.attacks[offset + (pext ? length : (occ * magic) >> (64 - shift))].bb = attacks;
+
+                length++;
+                occ = (occ - mask) & mask;
+            } while (occ != 0);
+        }
+        return table;
+    }
+
+    // Only the tables of the layouts the build can select are generated.
+    template<PieceType pt, bool pext>
+    constexpr AttackTable<ATTACK_TABLE_SIZE<pt>> attack_table = generate_attack_table<pt, pext>();
+
+    // Converts the magic and the occupancy bitboard into an index in the lookup table with PEXT.
+    // The CPU must support BMI2, which is only checked at startup for BMI2 builds.
+    [[nodiscard]] uint64_t get_pext_index(const Magic &m, Bitboard occ) {
+#if defined(BMI2)
+        return _pext_u64(occ.bb, m.mask.bb);
+#else
+        // Inline assembly doesn't require the whole function to be compiled for BMI2.
+        uint64_t index;
+        asm("pextq %2, %1, %0" : "=r"(index) : "r"(occ.bb), "r"(m.mask.bb));
+        return index;
+#endif
+    }
+
+    // Looks up the attacked squares of pt from the square of the magic entry, in the table of the given layout.
+    template<PieceType pt, bool pext>
+    [[nodiscard]] Bitboard lookup_magic(const Magic &m, Bitboard occ) {
+        if constexpr (pext) {
+            return attack_table<pt, true>.attacks[m.offset + get_pext_index(m, occ)];
+        } else {
+            return attack_table<pt, false>.attacks[m.offset + get_multiply_index(m, occ)];
+        }
+    }
+
+    // Looks up the attacked squares of pt from the square of the magic entry, in the table of the selected layout.
+    template<PieceType pt>
+    [[nodiscard]] Bitboard lookup_magic(const Magic &m, Bitboard occ) {
+#if defined(DISPATCH)
+        return use_pext ? lookup_magic<pt, true>(m, occ) : lookup_magic<pt, false>(m, occ);
+#else
+        return lookup_magic<pt, use_pext>(m, occ);
+#endif
     }
-} // namespace chess
\ No newline at end of file
+} // namespace chess
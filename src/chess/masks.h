@@ -17,95 +17,95 @@
 
 #pragma once
 
+#include "../utils/utilities.h"
 #include "bitboard.h"
 
 namespace chess {
-    extern Bitboard masks_adjacent_file[64];
-    extern Bitboard masks_adjacent_north[64];
-    extern Bitboard masks_adjacent_south[64];
-    extern Bitboard masks_pawn[64][2];
-    extern Bitboard masks_passed_pawn[64][2];
-    extern Bitboard masks_knight[64];
-    extern Bitboard masks_king[64];
-    extern Bitboard masks_file[64];
-    extern Bitboard masks_rank[64];
-    extern Bitboard masks_rook[64];
-    extern Bitboard masks_diagonal[64];
-    extern Bitboard masks_anti_diagonal[64];
-    extern Bitboard masks_bishop[64];
-    extern Bitboard masks_common_ray[64][64];
-    extern LineType line_type[64][64];
-
-    /*
-     * Initializes masks. Must be called
-     * before calling the move generator.
-     */
-    void init_masks() {
+    // The masks used by the move generator and the evaluation, generated at compile time.
+    struct Masks {
+        Bitboard adjacent_file[64];
+        Bitboard adjacent_north[64];
+        Bitboard adjacent_south[64];
+        Bitboard pawn[64][2];
+        Bitboard passed_pawn[64][2];
+        Bitboard knight[64];
+        Bitboard king[64];
+        Bitboard file[64];
+        Bitboard rank[64];
+        Bitboard rook[64];
+        Bitboard diagonal[64];
+        Bitboard anti_diagonal[64];
+        Bitboard bishop[64];
+        // The squares along DIRECTIONS[i] from a square, excluding the square itself.
+        Bitboard ray[8][64];
+        Bitboard common_ray[64][64];
+        LineType line_type[64][64];
+    };
+
+    [[nodiscard]] constexpr Masks generate_masks() {
+        Masks m{};
 
         for (Square sq = A1; sq < 64; sq += 1) {
-            masks_bit[sq] = 1ULL << sq;
+            const Bitboard bit = sq;
 
-            masks_pawn[sq][WHITE] = step<NORTH_WEST>(masks_bit[sq]) | step<NORTH_EAST>(masks_bit[sq]);
-            masks_pawn[sq][BLACK] = step<SOUTH_WEST>(masks_bit[sq]) | step<SOUTH_EAST>(masks_bit[sq]);
+            m.pawn[sq][WHITE] = step<NORTH_WEST>(bit) | step<NORTH_EAST>(bit);
+            m.pawn[sq][BLACK] = step<SOUTH_WEST>(bit) | step<SOUTH_EAST>(bit);
 
-            masks_knight[sq] =
-                    step<NORTH>(step<NORTH_WEST>(masks_bit[sq])) | step<NORTH>(step<NORTH_EAST>(masks_bit[sq])) |
-                    step<WEST>(step<NORTH_WEST>(masks_bit[sq])) | step<EAST>(step<NORTH_EAST>(masks_bit[sq])) |
-                    step<SOUTH>(step<SOUTH_WEST>(masks_bit[sq])) | step<SOUTH>(step<SOUTH_EAST>(masks_bit[sq])) |
-                    step<WEST>(step<SOUTH_WEST>(masks_bit[sq])) | step<EAST>(step<SOUTH_EAST>(masks_bit[sq]));
+            m.knight[sq] = step<NORTH>(step<NORTH_WEST>(bit)) | step<NORTH>(step<NORTH_EAST>(bit)) | step<WEST>(step<NORTH_WEST>(bit)) |
+                           step<EAST>(step<NORTH_EAST>(bit)) | step<SOUTH>(step<SOUTH_WEST>(bit)) | step<SOUTH>(step<SOUTH_EAST>(bit)) |
+                           step<WEST>(step<SOUTH_WEST>(bit)) | step<EAST>(step<SOUTH_EAST>(bit));
 
-            masks_king[sq] =
-                    step<NORTH>(masks_bit[sq]) | step<NORTH_WEST>(masks_bit[sq]) | step<WEST>(masks_bit[sq]) |
-                    step<NORTH_EAST>(masks_bit[sq]) |
-                    step<SOUTH>(masks_bit[sq]) | step<SOUTH_WEST>(masks_bit[sq]) | step<EAST>(masks_bit[sq]) |
-                    step<SOUTH_EAST>(masks_bit[sq]);
+            m.king[sq] = step<NORTH>(bit) | step<NORTH_WEST>(bit) | step<WEST>(bit) | step<NORTH_EAST>(bit) | step<SOUTH>(bit) |
+                         step<SOUTH_WEST>(bit) | step<EAST>(bit) | step<SOUTH_EAST>(bit);
 
-            masks_file[sq] = slide<NORTH>(sq) | slide<SOUTH>(sq);
+            m.file[sq] = slide<NORTH>(sq) | slide<SOUTH>(sq);
 
-            masks_rank[sq] = slide<WEST>(sq) | slide<EAST>(sq);
+            m.rank[sq] = slide<WEST>(sq) | slide<EAST>(sq);
 
-            masks_rook[sq] = masks_file[sq] | masks_rank[sq];
+            m.rook[sq] = m.file[sq] | m.rank[sq];
 
-            masks_diagonal[sq] = slide<NORTH_EAST>(sq) | slide<SOUTH_WEST>(sq);
+            m.diagonal[sq] = slide<NORTH_EAST>(sq) | slide<SOUTH_WEST>(sq);
 
-            masks_anti_diagonal[sq] = slide<NORTH_WEST>(sq) | slide<SOUTH_EAST>(sq);
+            m.anti_diagonal[sq] = slide<NORTH_WEST>(sq) | slide<SOUTH_EAST>(sq);
 
-            masks_bishop[sq] = masks_diagonal[sq] | masks_anti_diagonal[sq];
+            m.bishop[sq] = m.diagonal[sq] | m.anti_diagonal[sq];
+
+            for (unsigned int dir = 0; dir < 8; dir++) {
+                m.ray[dir][sq] = slide(DIRECTIONS[dir], sq);
+            }
         }
 
         for (Square sq = A1; sq < 64; sq += 1) {
             unsigned int file = square_to_file(sq);
 
-            masks_adjacent_north[sq] = slide<NORTH>(sq) | (file != 0 ? slide<NORTH>(sq + WEST) : 0) |
-                                       (file != 7 ? slide<NORTH>(sq + EAST) : 0);
-            masks_adjacent_south[sq] = slide<SOUTH>(sq) | (file != 0 ? slide<SOUTH>(sq + WEST) : 0) |
-                                       (file != 7 ? slide<SOUTH>(sq + EAST) : 0);
-            masks_adjacent_file[sq] =
-                    ~masks_file[sq] & (masks_adjacent_north[sq] | masks_adjacent_south[sq] | step<WEST>(sq) | step<EAST>(sq));
+            m.adjacent_north[sq] = slide<NORTH>(sq) | (file != 0 ? slide<NORTH>(sq + WEST) : 0) | (file != 7 ? slide<NORTH>(sq + EAST) : 0);
+            m.adjacent_south[sq] = slide<SOUTH>(sq) | (file != 0 ? slide<SOUTH>(sq + WEST) : 0) | (file != 7 ? slide<SOUTH>(sq + EAST) : 0);
+            m.adjacent_file[sq] = ~m.file[sq] & (m.adjacent_north[sq] | m.adjacent_south[sq] | step<WEST>(sq) | step<EAST>(sq));
 
-            masks_passed_pawn[sq][WHITE] = slide<NORTH>(sq);
-            masks_passed_pawn[sq][BLACK] = slide<SOUTH>(sq);
+            m.passed_pawn[sq][WHITE] = slide<NORTH>(sq);
+            m.passed_pawn[sq][BLACK] = slide<SOUTH>(sq);
 
             if (!FILE_A.get(sq)) {
-                masks_passed_pawn[sq][WHITE] |= slide<NORTH>(sq + WEST);
-                masks_passed_pawn[sq][BLACK] |= slide<SOUTH>(sq + WEST);
+                m.passed_pawn[sq][WHITE] |= slide<NORTH>(sq + WEST);
+                m.passed_pawn[sq][BLACK] |= slide<SOUTH>(sq + WEST);
             }
             if (!FILE_H.get(sq)) {
-                masks_passed_pawn[sq][WHITE] |= slide<NORTH>(sq + EAST);
-                masks_passed_pawn[sq][BLACK] |= slide<SOUTH>(sq + EAST);
+                m.passed_pawn[sq][WHITE] |= slide<NORTH>(sq + EAST);
+                m.passed_pawn[sq][BLACK] |= slide<SOUTH>(sq + EAST);
             }
 
             // Calculates the common ray and the line type of the shortest path between sq and sq2.
+            // DIRECTIONS lists the opposite of every direction 4 places later.
             for (Square sq2 = A1; sq2 < 64; sq2 += 1) {
                 if (sq == sq2)
                     continue;
-                for (Direction dir : DIRECTIONS) {
-                    Bitboard value = slide(dir, sq) & slide(-dir, sq2);
+                for (unsigned int dir = 0; dir < 8; dir++) {
+                    Bitboard value = m.ray[dir][sq] & m.ray[(dir + 4) % 8][sq2];
 
                     if (value) {
-                        masks_common_ray[sq][sq2] = value;
+                        m.common_ray[sq][sq2] = value;
                         LineType type = HORIZONTAL;
-                        switch (dir) {
+                        switch (DIRECTIONS[dir]) {
                             case NORTH:
                             case SOUTH:
                                 type = HORIZONTAL;
@@ -123,11 +123,32 @@ namespace chess {
                                 type = ANTI_DIAGONAL;
                                 break;
                         }
-                        line_type[sq][sq2] = type;
+                        m.line_type[sq][sq2] = type;
                         break;
                     }
                 }
             }
         }
+
+        return m;
     }
-} // namespace chess
\ No newline at end of file
+
+    constexpr Masks MASKS = generate_masks();
+
+    constexpr auto &masks_adjacent_file = MASKS.adjacent_file;
+    constexpr auto &masks_adjacent_north = MASKS.adjacent_north;
+    constexpr auto &masks_adjacent_south = MASKS.adjacent_south;
+    constexpr auto &masks_pawn = MASKS.pawn;
+    constexpr auto &masks_passed_pawn = MASKS.passed_pawn;
+    constexpr auto &masks_knight = MASKS.knight;
+    constexpr auto &masks_king = MASKS.king;
+    constexpr auto &masks_file = MASKS.file;
+    constexpr auto &masks_rank = MASKS.rank;
+    constexpr auto &masks_rook = MASKS.rook;
+    constexpr auto &masks_diagonal = MASKS.diagonal;
+    constexpr auto &masks_anti_diagonal = MASKS.anti_diagonal;
+    constexpr auto &masks_bishop = MASKS.bishop;
+    constexpr auto &masks_ray = MASKS.ray;
+    constexpr auto &masks_common_ray = MASKS.common_ray;
+    constexpr auto &line_type = MASKS.line_type;
+} // namespace chess
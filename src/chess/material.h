@@ -0,0 +1,223 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "constants.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace chess {
+
+    // The number of pieces of every color and type in 4 bits each, updated incrementally by the board.
+    struct MaterialKey {
+        uint64_t key = 0;
+
+        static constexpr unsigned int shift(Color color, PieceType type) {
+            return 4 * (6 * color + type);
+        }
+
+        constexpr void add(Piece piece) {
+            key += uint64_t(1) << shift(piece.color, piece.type);
+        }
+
+        constexpr void remove(Piece piece) {
+            key -= uint64_t(1) << shift(piece.color, piece.type);
+        }
+
+        [[nodiscard]] constexpr unsigned int count(Color color, PieceType type) const {
+            return key >> shift(color, type) & 15;
+        }
+
+        [[nodiscard]] constexpr Score material(Color color) const {
+            Score value = 0;
+            for (const PieceType type : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN}) {
+                value += PIECE_VALUES[type] * Score(count(color, type));
+            }
+            return value;
+        }
+
+        // The value of the knights, bishops, rooks and queens of both sides
+        [[nodiscard]] constexpr Score non_pawn_material() const {
+            return material(WHITE) + material(BLACK) - PIECE_VALUES[PAWN] * Score(count(WHITE, PAWN) + count(BLACK, PAWN));
+        }
+
+        constexpr bool operator==(const MaterialKey &) const = default;
+    };
+
+    enum MaterialKind : uint8_t {
+        MATERIAL_NORMAL,
+        // Checkmate is impossible, only the kings and at most a single minor piece are left
+        MATERIAL_DRAW,
+        // Drawn unless the weaker side walks into a mate, so it is evaluated as a draw but still searched
+        MATERIAL_DRAWISH,
+        // A queen or rook with at most one more piece and any pawns against the lone king
+        MATERIAL_WIN_WHITE,
+        MATERIAL_WIN_BLACK,
+        // A single queen, rook or pawn, which is found in the bitbases
+        MATERIAL_BITBASE
+    };
+
+    constexpr unsigned int SCALE_NORMAL = 64;
+
+    struct MaterialEntry {
+        MaterialKey key;
+        MaterialKind kind = MATERIAL_NORMAL;
+        // The evaluation is scaled by scale / SCALE_NORMAL, with opposite bishops only if they are on different colors
+        uint8_t scale = SCALE_NORMAL;
+        bool opposite_bishops = false;
+    };
+
+    struct MaterialSide {
+        unsigned int pawns = 0, knights = 0, bishops = 0, rooks = 0, queens = 0;
+
+        [[nodiscard]] constexpr unsigned int minors() const {
+            return knights + bishops;
+        }
+
+        [[nodiscard]] constexpr unsigned int majors() const {
+            return rooks + queens;
+        }
+
+        [[nodiscard]] constexpr Score value() const {
+            return PIECE_VALUES[PAWN] * pawns + PIECE_VALUES[KNIGHT] * knights + PIECE_VALUES[BISHOP] * bishops +
+                   PIECE_VALUES[ROOK] * rooks + PIECE_VALUES[QUEEN] * queens;
+        }
+    };
+
+    constexpr MaterialKey material_key(const MaterialSide &white, const MaterialSide &black) {
+        MaterialKey key;
+        for (const Color color : {WHITE, BLACK}) {
+            const MaterialSide &side = color == WHITE ? white : black;
+            key.add(Piece(KING, color));
+            key.key += uint64_t(side.pawns) << MaterialKey::shift(color, PAWN) | uint64_t(side.knights) << MaterialKey::shift(color, KNIGHT) |
+                       uint64_t(side.bishops) << MaterialKey::shift(color, BISHOP) | uint64_t(side.rooks) << MaterialKey::shift(color, ROOK) |
+                       uint64_t(side.queens) << MaterialKey::shift(color, QUEEN);
+        }
+        return key;
+    }
+
+    // Pawnless signatures with at most two pieces on both sides
+    constexpr MaterialEntry classify_pawnless(const MaterialSide &white, const MaterialSide &black) {
+        MaterialEntry entry{material_key(white, black)};
+        const bool white_strong = white.value() >= black.value();
+        const MaterialSide &strong = white_strong ? white : black, &weak = white_strong ? black : white;
+        const unsigned int strong_pieces = strong.minors() + strong.majors(), weak_pieces = weak.minors() + weak.majors();
+
+        if (strong.majors() == 0) {
+            // Minor pieces can not force mate, except two of them against a bare king, but two knights can not do that either
+            if (strong_pieces + weak_pieces <= 1) {
+                entry.kind = MATERIAL_DRAW;
+            } else if (strong_pieces <= 1 || (strong.knights == 2 && weak_pieces == 0)) {
+                entry.kind = MATERIAL_DRAWISH;
+            } else if (weak_pieces != 0) {
+                entry.scale = 16;
+            }
+        } else if (weak_pieces == 0) {
+            if (strong_pieces == 1) {
+                entry.kind = MATERIAL_BITBASE;
+            } else {
+                entry.kind = white_strong ? MATERIAL_WIN_WHITE : MATERIAL_WIN_BLACK;
+            }
+        } else if (strong.rooks == 1 && strong_pieces == 1 && weak.minors() == 1 && weak_pieces == 1) {
+            // A rook against a minor piece
+            entry.scale = 16;
+        } else if (strong.rooks == 1 && strong_pieces == 2 && strong.minors() == 1 && weak.rooks == 1 && weak_pieces == 1) {
+            // A rook and a minor piece against a rook
+            entry.scale = 16;
+        } else if (strong_pieces == 1 && weak_pieces == 1 && strong.rooks == weak.rooks && strong.queens == weak.queens) {
+            // A rook or queen against the same
+            entry.scale = 16;
+        }
+        return entry;
+    }
+
+    constexpr unsigned int MATERIAL_TABLE_SIZE = 1024;
+
+    constexpr unsigned int material_index(MaterialKey key) {
+        return (key.key * 0x9E3779B97F4A7C15ULL) >> 54;
+    }
+
+    // An open addressing table of the signatures that are not evaluated normally, generated at compile time.
+    constexpr std::array<MaterialEntry, MATERIAL_TABLE_SIZE> generate_material_table() {
+        std::array<MaterialEntry, MATERIAL_TABLE_SIZE> table{};
+        auto insert = [&table](const MaterialEntry &entry) {
+            unsigned int index = material_index(entry.key);
+            while (table[index].key.key != 0) index = (index + 1) % MATERIAL_TABLE_SIZE;
+            table[index] = entry;
+        };
+
+        // The sets of at most two pieces, 0 stands for no piece and 1 to 4 for a knight, bishop, rook or queen
+        std::array<MaterialSide, 15> sides{};
+        unsigned int side_count = 0;
+        for (unsigned int first = 0; first <= 4; first++) {
+            for (unsigned int second = first; second <= 4; second++) {
+                MaterialSide &side = sides[side_count++];
+                for (const unsigned int piece : {first, second}) {
+                    side.knights += piece == 1;
+                    side.bishops += piece == 2;
+                    side.rooks += piece == 3;
+                    side.queens += piece == 4;
+                }
+            }
+        }
+
+        for (const MaterialSide &white : sides) {
+            for (const MaterialSide &black : sides) {
+                const MaterialEntry entry = classify_pawnless(white, black);
+                if (entry.kind != MATERIAL_NORMAL || entry.scale != SCALE_NORMAL) insert(entry);
+
+                // The lone king can not stop the pawns either
+                const bool white_wins = entry.kind == MATERIAL_WIN_WHITE || (entry.kind == MATERIAL_BITBASE && white.majors() == 1);
+                for (unsigned int pawns = 1; pawns <= 8 && (entry.kind == MATERIAL_WIN_WHITE || entry.kind == MATERIAL_WIN_BLACK || entry.kind == MATERIAL_BITBASE); pawns++) {
+                    MaterialSide strong = white_wins ? white : black;
+                    strong.pawns = pawns;
+                    const MaterialSide &weak = white_wins ? black : white;
+                    insert({white_wins ? material_key(strong, weak) : material_key(weak, strong), white_wins ? MATERIAL_WIN_WHITE : MATERIAL_WIN_BLACK});
+                }
+            }
+        }
+
+        // A single pawn
+        insert({material_key({.pawns = 1}, {}), MATERIAL_BITBASE});
+        insert({material_key({}, {.pawns = 1}), MATERIAL_BITBASE});
+
+        // Opposite colored bishops with pawns, the extra pawns are worth less than usual
+        for (unsigned int white_pawns = 0; white_pawns <= 8; white_pawns++) {
+            for (unsigned int black_pawns = white_pawns == 0; black_pawns <= 8; black_pawns++) {
+                const unsigned int difference = white_pawns > black_pawns ? white_pawns - black_pawns : black_pawns - white_pawns;
+                insert({material_key({.pawns = white_pawns, .bishops = 1}, {.pawns = black_pawns, .bishops = 1}), MATERIAL_NORMAL,
+                        uint8_t(std::min(16 + 8 * difference, SCALE_NORMAL)), true});
+            }
+        }
+
+        return table;
+    }
+
+    constexpr std::array<MaterialEntry, MATERIAL_TABLE_SIZE> material_table = generate_material_table();
+
+    // Returns the entry of the signature, or an empty one that is evaluated normally if it is not in the table.
+    const MaterialEntry &probe_material(MaterialKey key) {
+        for (unsigned int index = material_index(key);; index = (index + 1) % MATERIAL_TABLE_SIZE) {
+            const MaterialEntry &entry = material_table[index];
+            if (entry.key == key || entry.key.key == 0) return entry;
+        }
+    }
+
+} // namespace chess
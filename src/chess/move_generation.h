@@ -138,6 +138,37 @@ namespace chess {
         return moves;
     }
 
+    // Returns whether capturing en passant with the pawn on 'pawn_attacking' would expose the king to a slider,
+    // because both pawns leave the rank or the diagonal between them.
+    template<Color color>
+    [[nodiscard]] bool is_ep_pinned(const Board &board, Square king, Square pawn_attacking) {
+        constexpr Color enemy_color = color_enemy<color>();
+        constexpr Direction DOWN = color == WHITE ? -NORTH : NORTH;
+
+        Square pawn_attacked = board.get_ep() + DOWN;
+
+        Bitboard occ = board.occupied();
+        occ.clear(pawn_attacking);
+        occ.clear(pawn_attacked);
+
+        Bitboard attack_rook = attacks_rook(pawn_attacked, occ);
+        Bitboard attack_bishop = attacks_bishop(pawn_attacked, occ);
+
+        Bitboard attack_rank = masks_rank[pawn_attacked] & attack_rook;
+        Bitboard attack_diag = masks_diagonal[pawn_attacked] & attack_bishop;
+        Bitboard attack_adiag = masks_anti_diagonal[pawn_attacked] & attack_bishop;
+
+        Bitboard rank_seen_sliders = (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, ROOK>()) & attack_rank;
+        Bitboard diag_seen_sliders = (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, BISHOP>()) & attack_diag;
+        Bitboard adiag_seen_sliders = (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, BISHOP>()) & attack_adiag;
+
+        bool rank_pin = attack_rank.get(king) && rank_seen_sliders;
+        bool diag_pin = attack_diag.get(king) && diag_seen_sliders;
+        bool adiag_pin = attack_adiag.get(king) && adiag_seen_sliders;
+
+        return rank_pin || diag_pin || adiag_pin;
+    }
+
     // Generates all legal pawn moves for all the 'color' pawns in 'board' board and
     // adds them to the 'moves' move list.
     // 'captures_only' - if true, only generates capture moves
@@ -256,77 +287,18 @@ namespace chess {
         if ((square_ep != NULL_SQUARE) && (masks_pawn[board.get_ep()][enemy_color] & pawns) &&
             mask_check.get(square_ep + DOWN)) {
 
-            // Get the occupied squares
-            Bitboard occ = board.occupied();
-
             // Check if there is a pawn on the right side of the square_ep that can move diagonally
             bool ep_right = (step<UP_RIGHT>(pawns & moveD)).get(square_ep);
             // Check if there is a pawn on the right side of the square_ep that can move anti-diagonally
             bool ep_left = (step<UP_LEFT>(pawns & moveA)).get(square_ep);
 
             // If there is a pawn on the right side
-            if (ep_right) {
-                Square pawn_attacking = square_ep + DOWN_LEFT;
-                Square pawn_attacked = square_ep + DOWN;
-
-                occ.clear(pawn_attacking);
-                occ.clear(pawn_attacked);
-
-                Bitboard attack_rook = attacks_rook(pawn_attacked, occ);
-                Bitboard attack_bishop = attacks_bishop(pawn_attacked, occ);
-
-                Bitboard attack_rank = masks_rank[pawn_attacked] & attack_rook;
-                Bitboard attack_diag = masks_diagonal[pawn_attacked] & attack_bishop;
-                Bitboard attack_adiag = masks_anti_diagonal[pawn_attacked] & attack_bishop;
-
-                Bitboard rank_seen_sliders = (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, ROOK>()) & attack_rank;
-                Bitboard diag_seen_sliders =
-                        (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, BISHOP>()) & attack_diag;
-                Bitboard adiag_seen_sliders =
-                        (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, BISHOP>()) & attack_adiag;
-
-                bool rank_pin = attack_rank.get(king) && rank_seen_sliders;
-                bool diag_pin = attack_diag.get(king) && diag_seen_sliders;
-                bool adiag_pin = attack_adiag.get(king) && adiag_seen_sliders;
-
-                if (!(rank_pin || diag_pin || adiag_pin))
-                    *moves++ = Move(pawn_attacking, square_ep, Move::EP_CAPTURE);
-
-                occ.set(pawn_attacking);
-                occ.set(pawn_attacked);
-            }
+            if (ep_right && !is_ep_pinned<color>(board, king, square_ep + DOWN_LEFT))
+                *moves++ = Move(square_ep + DOWN_LEFT, square_ep, Move::EP_CAPTURE);
 
             // If there is a pawn on the left side
-            if (ep_left) {
-                Square pawn_attacking = square_ep + DOWN_RIGHT;
-                Square pawn_attacked = square_ep + DOWN;
-
-                occ.clear(pawn_attacking);
-                occ.clear(pawn_attacked);
-
-                Bitboard attack_rook = attacks_rook(pawn_attacked, occ);
-                Bitboard attack_bishop = attacks_bishop(pawn_attacked, occ);
-
-                Bitboard attack_rank = masks_rank[pawn_attacked] & attack_rook;
-                Bitboard attack_diag = masks_diagonal[pawn_attacked] & attack_bishop;
-                Bitboard attack_adiag = masks_anti_diagonal[pawn_attacked] & attack_bishop;
-
-                Bitboard rank_seen_sliders = (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, ROOK>()) & attack_rank;
-                Bitboard rank_seen_diag =
-                        (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, BISHOP>()) & attack_diag;
-                Bitboard rank_seen_adiag =
-                        (board.pieces<enemy_color, QUEEN>() | board.pieces<enemy_color, BISHOP>()) & attack_adiag;
-
-                bool rank_pin = attack_rank.get(king) && rank_seen_sliders;
-                bool diag_pin = attack_diag.get(king) && rank_seen_diag;
-                bool adiag_pin = attack_adiag.get(king) && rank_seen_adiag;
-
-                if (!(rank_pin || diag_pin || adiag_pin))
-                    *moves++ = Move(pawn_attacking, square_ep, Move::EP_CAPTURE);
-
-                occ.set(pawn_attacking);
-                occ.set(pawn_attacked);
-            }
+            if (ep_left && !is_ep_pinned<color>(board, king, square_ep + DOWN_RIGHT))
+                *moves++ = Move(square_ep + DOWN_RIGHT, square_ep, Move::EP_CAPTURE);
         }
 
         return moves;
@@ -399,36 +371,43 @@ namespace chess {
         return moves;
     }
 
-    // Generates all the legal moves in a board.
-    template<Color color, bool captures_only>
-    [[nodiscard]] Move *gen_moves(const Board &board, Move *moves) {
+    // The checks and pins of the side to move, which legal move generation is based on.
+    struct MoveGenInfo {
+        Square king;
+        Bitboard squares_safe;
+        // The "to" squares which evade check. It is 0 in double check, and then the pins are not calculated.
+        Bitboard mask_check;
+        Bitboard pinHV, pinDA, moveH, moveV, moveD, moveA;
+    };
+
+    template<Color color>
+    [[nodiscard]] MoveGenInfo gen_move_info(const Board &board) {
         // Define enemy color
         constexpr Color enemyColor = color_enemy<color>();
 
+        MoveGenInfo info;
+
         // Define friendly king square
         Square king = board.pieces<color, KING>().lsb();
         assert(king != NULL_SQUARE);
+        info.king = king;
 
         // Define bitboards used for move generation
         Bitboard pieces_friendly = board.sides<color>();
-        Bitboard empty = board.empty();
         Bitboard enemy = board.sides<enemyColor>();
         Bitboard occupied = board.occupied();
         Bitboard checkers = get_attackers<color>(board, king);
 
         occupied.clear(king);
-        Bitboard squares_safe = ~get_attacked_squares<enemyColor>(board, occupied);
+        info.squares_safe = ~get_attacked_squares<enemyColor>(board, occupied);
         occupied.set(king);
 
         // Generate mask_check
-        Bitboard mask_check = gen_check_mask(board, king, checkers);
-
-        // Generate king moves
-        moves = gen_king_moves<captures_only>(board, moves, king, squares_safe, empty, enemy);
+        info.mask_check = gen_check_mask(board, king, checkers);
 
         // If we are in a double check, only king moves are legal
-        if (mask_check == 0)
-            return moves;
+        if (info.mask_check == 0)
+            return info;
 
         // Generate pinMasks
         Bitboard squares_seen = attacks_piece<QUEEN>(king, occupied);
@@ -444,7 +423,7 @@ namespace chess {
                            possible_pinners;
 
         // Define bitboards used for storing pin information
-        Bitboard pinH, pinV, pinD, pinA, pinHV, pinDA, moveH, moveV, moveD, moveA;
+        Bitboard pinH, pinV, pinD, pinA;
 
         // Calculate pins
         while (pinners) {
@@ -466,33 +445,57 @@ namespace chess {
             }
         }
 
-        pinHV = pinH | pinV;
-        pinDA = pinD | pinA;
+        info.pinHV = pinH | pinV;
+        info.pinDA = pinD | pinA;
 
         pinH &= pieces_friendly;
         pinV &= pieces_friendly;
         pinD &= pieces_friendly;
         pinA &= pieces_friendly;
 
-        moveH = ~(pinV | pinD | pinA);
-        moveV = ~(pinH | pinD | pinA);
-        moveD = ~(pinH | pinV | pinA);
-        moveA = ~(pinH | pinV | pinD);
+        info.moveH = ~(pinV | pinD | pinA);
+        info.moveV = ~(pinH | pinD | pinA);
+        info.moveD = ~(pinH | pinV | pinA);
+        info.moveA = ~(pinH | pinV | pinD);
 
-        occupied ^= possible_pins;
+        return info;
+    }
+
+    // Generates all the legal moves in a board.
+    template<Color color, bool captures_only>
+    [[nodiscard]] Move *gen_moves(const Board &board, Move *moves) {
+        // Define enemy color
+        constexpr Color enemyColor = color_enemy<color>();
+
+        const MoveGenInfo info = gen_move_info<color>(board);
+        const Square king = info.king;
+
+        // Define bitboards used for move generation
+        Bitboard pieces_friendly = board.sides<color>();
+        Bitboard empty = board.empty();
+        Bitboard enemy = board.sides<enemyColor>();
+        Bitboard occupied = board.occupied();
+
+        // Generate king moves
+        moves = gen_king_moves<captures_only>(board, moves, king, info.squares_safe, empty, enemy);
+
+        // If we are in a double check, only king moves are legal
+        if (info.mask_check == 0)
+            return moves;
 
         // Generate pawn moves
-        moves = gen_pawn_moves<color, captures_only>(board, moves, king, mask_check, moveH, moveV, moveD, moveA);
+        moves = gen_pawn_moves<color, captures_only>(board, moves, king, info.mask_check, info.moveH, info.moveV, info.moveD, info.moveA);
 
         // Generate knight and slider moves
         Bitboard pieces_slider_and_jumper = pieces_friendly & ~board.pieces<PAWN>();
         pieces_slider_and_jumper.clear(king);
 
         moves = gen_slider_and_jumper<captures_only>(board, moves, pieces_slider_and_jumper, occupied, empty, enemy,
-                                                     mask_check, pinHV, pinDA);
+                                                     info.mask_check, info.pinHV, info.pinDA);
 
         // Generate castling moves
         if constexpr (!captures_only) {
+            const Bitboard squares_safe = info.squares_safe;
             if constexpr (color == WHITE) {
                 if (board.get_rights()[CastlingRights::WHITE_KING] &&
                     (squares_safe & WK_CASTLE_SAFE) == WK_CASTLE_SAFE && (empty & WK_CASTLE_EMPTY) == WK_CASTLE_EMPTY) {
@@ -523,6 +526,132 @@ namespace chess {
         return moves;
     }
 
+    // Counts the legal moves of the pieces to the 'targets' squares, like gen_moves_from_pieces.
+    template<bool pinHV, bool pinDA, bool any_move>
+    [[nodiscard]] unsigned int count_moves_from_pieces(const Board &board, Bitboard pieces, Bitboard targets, Bitboard occupied) {
+        unsigned int count = 0;
+        while (pieces) {
+            Square from = pieces.pop_lsb();
+            Bitboard attacks = attacks_piece(board.piece_at(from).type, from, occupied) & targets;
+
+            if constexpr (pinHV)
+                attacks &= masks_rook[from];
+
+            if constexpr (pinDA)
+                attacks &= masks_bishop[from];
+
+            count += attacks.pop_count();
+            if constexpr (any_move) {
+                if (count)
+                    return count;
+            }
+        }
+        return count;
+    }
+
+    // Counts the legal pawn moves, like gen_pawn_moves. Promotions count as 4 moves.
+    template<Color color>
+    [[nodiscard]] unsigned int count_pawn_moves(const Board &board, const MoveGenInfo &info) {
+        constexpr Color enemy_color = color_enemy<color>();
+
+        constexpr Direction UP = color == WHITE ? NORTH : -NORTH;
+        constexpr Direction UP_LEFT = color == WHITE ? NORTH_WEST : -NORTH_WEST;
+        constexpr Direction UP_RIGHT = color == WHITE ? NORTH_EAST : -NORTH_EAST;
+        constexpr Direction DOWN = -UP;
+        constexpr Direction DOWN_LEFT = -UP_RIGHT;
+        constexpr Direction DOWN_RIGHT = -UP_LEFT;
+
+        constexpr Bitboard rank_double_push = (color == WHITE ? RANK_3 : RANK_6);
+        constexpr Bitboard rank_before_promo = (color == WHITE ? RANK_7 : RANK_2);
+
+        Square square_ep = board.get_ep();
+        Bitboard empty = board.empty();
+        Bitboard enemy = board.sides<enemy_color>();
+        Bitboard pawns = board.pieces<color, PAWN>();
+
+        Bitboard single_push = step<UP>(pawns & info.moveH) & empty;
+        Bitboard double_push = step<UP>(single_push & rank_double_push) & empty;
+        Bitboard captures_right = step<UP_RIGHT>(pawns & info.moveD) & enemy;
+        Bitboard captures_left = step<UP_LEFT>(pawns & info.moveA) & enemy;
+
+        // Every pawn move of the pawns before promotion lands on the last rank
+        constexpr Bitboard rank_promo = step<UP>(rank_before_promo);
+        unsigned int count = ((single_push & ~rank_promo & info.mask_check).pop_count() + (double_push & info.mask_check).pop_count() +
+                              (captures_right & ~rank_promo & info.mask_check).pop_count() + (captures_left & ~rank_promo & info.mask_check).pop_count()) +
+                             4 * ((single_push & rank_promo & info.mask_check).pop_count() + (captures_right & rank_promo & info.mask_check).pop_count() +
+                                  (captures_left & rank_promo & info.mask_check).pop_count());
+
+        if ((square_ep != NULL_SQUARE) && (masks_pawn[square_ep][enemy_color] & pawns) && info.mask_check.get(square_ep + DOWN)) {
+            count += step<UP_RIGHT>(pawns & info.moveD).get(square_ep) && !is_ep_pinned<color>(board, info.king, square_ep + DOWN_LEFT);
+            count += step<UP_LEFT>(pawns & info.moveA).get(square_ep) && !is_ep_pinned<color>(board, info.king, square_ep + DOWN_RIGHT);
+        }
+
+        return count;
+    }
+
+    // Counts the legal moves in a board with popcounts, without generating them.
+    // With 'any_move' it returns as soon as some legal moves are found, so only whether the result is 0 is meaningful.
+    template<Color color, bool any_move>
+    [[nodiscard]] unsigned int count_moves(const Board &board) {
+        const MoveGenInfo info = gen_move_info<color>(board);
+        const Bitboard targets = ~board.sides<color>();
+
+        unsigned int count = (masks_king[info.king] & info.squares_safe & targets).pop_count();
+        if (info.mask_check == 0 || (any_move && count))
+            return count;
+
+        Bitboard occupied = board.occupied();
+        Bitboard pieces = board.sides<color>() & ~board.pieces<PAWN>();
+        pieces.clear(info.king);
+        Bitboard pinnedHV = info.pinHV & pieces;
+        Bitboard pinnedDA = info.pinDA & pieces;
+        pieces &= ~(pinnedHV | pinnedDA);
+
+        count += count_moves_from_pieces<false, false, any_move>(board, pieces, targets & info.mask_check, occupied);
+        count += count_moves_from_pieces<true, false, any_move>(board, pinnedHV, targets & info.mask_check & info.pinHV, occupied);
+        count += count_moves_from_pieces<false, true, any_move>(board, pinnedDA, targets & info.mask_check & info.pinDA, occupied);
+        if (any_move && count)
+            return count;
+
+        count += count_pawn_moves<color>(board, info);
+        if (any_move)
+            return count;
+
+        // Castling is only counted if every move is needed, since it is never the only legal move
+        const Bitboard empty = board.empty();
+        if constexpr (color == WHITE) {
+            count += board.get_rights()[CastlingRights::WHITE_KING] && (info.squares_safe & WK_CASTLE_SAFE) == WK_CASTLE_SAFE &&
+                     (empty & WK_CASTLE_EMPTY) == WK_CASTLE_EMPTY;
+            count += board.get_rights()[CastlingRights::WHITE_QUEEN] && (info.squares_safe & WQ_CASTLE_SAFE) == WQ_CASTLE_SAFE &&
+                     (empty & WQ_CASTLE_EMPTY) == WQ_CASTLE_EMPTY;
+        } else {
+            count += board.get_rights()[CastlingRights::BLACK_KING] && (info.squares_safe & BK_CASTLE_SAFE) == BK_CASTLE_SAFE &&
+                     (empty & BK_CASTLE_EMPTY) == BK_CASTLE_EMPTY;
+            count += board.get_rights()[CastlingRights::BLACK_QUEEN] && (info.squares_safe & BQ_CASTLE_SAFE) == BQ_CASTLE_SAFE &&
+                     (empty & BQ_CASTLE_EMPTY) == BQ_CASTLE_EMPTY;
+        }
+
+        return count;
+    }
+
+    // Returns the number of legal moves of the side to move.
+    [[nodiscard]] unsigned int count_moves(const Board &board) {
+        if (board.get_stm() == WHITE) {
+            return count_moves<WHITE, false>(board);
+        } else {
+            return count_moves<BLACK, false>(board);
+        }
+    }
+
+    // Returns whether the side to move has any legal move, that is it is not mated or stalemated.
+    [[nodiscard]] bool has_legal_move(const Board &board) {
+        if (board.get_stm() == WHITE) {
+            return count_moves<WHITE, true>(board) != 0;
+        } else {
+            return count_moves<BLACK, true>(board) != 0;
+        }
+    }
+
     // Wrapper around the stm template.
     template<bool captures_only>
     [[nodiscard]] Move *gen_moves(const Board &board, Move *moves) {
@@ -542,6 +671,11 @@ namespace chess {
         }
     }
 
+    template<Color color>
+    bool Board::is_check() const {
+        return bool(chess::get_attackers<color>(*this, pieces<color, KING>().lsb()));
+    }
+
     bool Board::is_check() const {
         return bool(chess::get_attackers(*this, pieces<KING>(get_stm()).lsb()));
     }
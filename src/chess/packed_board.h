@@ -0,0 +1,129 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "fen.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string>
+
+namespace chess {
+
+    // A position in 32 bytes, which is the record of the binary training data format.
+    // The records are written as they are in memory, so the format is little-endian.
+    struct PackedBoard {
+        // The occupied squares
+        uint64_t occupancy = 0;
+        // 4 bits for every occupied square in the order of the squares, starting with the low bits of the first byte.
+        // The lower 3 bits are the piece type, the highest one is the color. Rooks that can still castle have the type CASTLING_ROOK.
+        uint8_t pieces[16] = {};
+        // The en passant square and the side to move in the highest bit
+        uint8_t stm_ep = NULL_SQUARE;
+        uint8_t move50 = 0;
+        uint16_t ply = 0;
+        // The static evaluation or search score relative to the side to move, and the result of the game
+        int16_t eval = 0;
+        uint8_t result = RESULT_DRAW;
+        uint8_t unused = 0;
+
+        static constexpr uint8_t CASTLING_ROOK = 6;
+        static constexpr uint8_t RESULT_BLACK_WIN = 0, RESULT_DRAW = 1, RESULT_WHITE_WIN = 2;
+    };
+
+    static_assert(sizeof(PackedBoard) == 32);
+
+    constexpr std::string_view PACKED_DATA_EXTENSION = ".packed";
+
+    // Data files with the packed extension consist of PackedBoard records, everything else is text.
+    bool is_packed_data(const std::string &path) {
+        return path.ends_with(PACKED_DATA_EXTENSION);
+    }
+
+    // The castling right that a rook of the given color on square represents, or 0.
+    constexpr unsigned int castling_rook_right(Color color, unsigned int square) {
+        if (color == WHITE) {
+            return square == H1 ? CastlingRights::WHITE_KING : square == A1 ? CastlingRights::WHITE_QUEEN : 0;
+        }
+        return square == H8 ? CastlingRights::BLACK_KING : square == A8 ? CastlingRights::BLACK_QUEEN : 0;
+    }
+
+    // Packs a position of at most 32 pieces, the castling rights are only kept if their rook is on its square.
+    constexpr PackedBoard pack(const Fen &fen) {
+        PackedBoard packed;
+        unsigned int index = 0;
+        for (unsigned int square = 0; square < 64 && index < 32; square++) {
+            const Piece piece = fen.mailbox[square];
+            if (piece.is_null()) continue;
+
+            const unsigned int right = piece.type == ROOK ? castling_rook_right(piece.color, square) : 0;
+            const unsigned int type = right != 0 && fen.rights[right] ? PackedBoard::CASTLING_ROOK : piece.type;
+
+            packed.occupancy |= uint64_t(1) << square;
+            packed.pieces[index / 2] |= uint8_t((type | piece.color << 3) << (index % 2 * 4));
+            index++;
+        }
+        packed.stm_ep = uint8_t(fen.ep | fen.stm << 7);
+        packed.move50 = uint8_t(std::min(fen.move50, 255u));
+        return packed;
+    }
+
+    constexpr Fen unpack(const PackedBoard &packed) {
+        Fen fen;
+        uint64_t occupancy = packed.occupancy;
+        for (unsigned int index = 0; occupancy && index < 32; index++) {
+            const unsigned int square = std::countr_zero(occupancy);
+            occupancy &= occupancy - 1;
+
+            const unsigned int nibble = packed.pieces[index / 2] >> (index % 2 * 4) & 15;
+            const Color color = Color(nibble >> 3);
+            unsigned int type = nibble & 7;
+            if (type == PackedBoard::CASTLING_ROOK) {
+                fen.rights += castling_rook_right(color, square);
+                type = ROOK;
+            }
+            fen.mailbox[square] = Piece(PieceType(type), color);
+        }
+        fen.stm = Color(packed.stm_ep >> 7);
+        fen.ep = Square(packed.stm_ep & 127);
+        fen.move50 = packed.move50;
+        return fen;
+    }
+
+    // Decodes only the pieces and their squares, in the order of the squares. Returns the number of pieces.
+    // Expanding the nibbles is independent of the occupancy, so it compiles to a few vector instructions.
+    unsigned int unpack_pieces(const PackedBoard &packed, Square *squares, Piece *pieces) {
+        uint8_t nibbles[32];
+        for (unsigned int i = 0; i < 16; i++) {
+            nibbles[2 * i] = packed.pieces[i] & 15;
+            nibbles[2 * i + 1] = packed.pieces[i] >> 4;
+        }
+
+        uint64_t occupancy = packed.occupancy;
+        unsigned int count = 0;
+        for (; occupancy && count < 32; count++) {
+            squares[count] = Square(std::countr_zero(occupancy));
+            occupancy &= occupancy - 1;
+            const unsigned int type = nibbles[count] & 7;
+            pieces[count] = Piece(type == PackedBoard::CASTLING_ROOK ? ROOK : PieceType(type), Color(nibbles[count] >> 3));
+        }
+        return count;
+    }
+
+} // namespace chess
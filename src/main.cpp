@@ -23,24 +23,15 @@
 #include <windows.h>
 #endif
 
-namespace chess {
-    // Declarations
-    Bitboard masks_bit[64], masks_adjacent_file[64], masks_adjacent_north[64], masks_adjacent_south[64], masks_pawn[64][2], masks_passed_pawn[64][2],
-            masks_knight[64], masks_king[64], masks_file[64], masks_rank[64], masks_rook[64], masks_diagonal[64],
-            masks_anti_diagonal[64], masks_bishop[64], masks_common_ray[64][64];
-    LineType line_type[64][64];
-    Bitboard attack_table_rook[102400], attack_table_bishop[5248];
-} // namespace chess
-
 namespace search {
-    Depth lmr_reductions[200][MAX_PLY + 1];
     int64_t TimeManager::MOVE_OVERHEAD = 30;
 } // namespace search
 
 void init_all() {
-    chess::init_masks();
-    chess::init_magic();
-    search::init_lmr();
+    cpu::init();
+    nn::simd::select(cpu::features);
+    chess::select_magic_index(cpu::features);
+    chess::bitbase::init();
 
     stat_tracker::add_stat("tt_hit");
     stat_tracker::add_stat("tt_cutoff");
@@ -50,6 +41,8 @@ void init_all() {
     stat_tracker::add_stat("pvs_see_capture");
     stat_tracker::add_stat("qsearch_see");
     stat_tracker::add_stat("skip_quiets");
+    stat_tracker::add_stat("singular");
+    stat_tracker::add_stat("probcut");
 }
 
 int main(int argc, char *argv[]) {
@@ -72,6 +65,8 @@ int main(int argc, char *argv[]) {
         test::run();
     } else if (mode == "bench") {
         run_bench();
+    } else if (mode == "sliderbench") {
+        run_slider_bench();
     } else {
         uci::UCI protocol;
         protocol.start();
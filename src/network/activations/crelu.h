@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "../../chess/constants.h"
+
 #include <algorithm>
 #include <immintrin.h>
 
@@ -30,8 +32,8 @@ namespace nn::activations {
             return std::clamp(value, static_cast<T>(0), UPPER_BOUND);
         }
 
-#ifdef AVX2
-        static __m256i _mm256_forward_epi16(__m256i value) {
+#ifdef KERNELS_AVX2
+        TARGET_AVX2 static __m256i _mm256_forward_epi16(__m256i value) {
             static_assert(std::is_same_v<T, int16_t>, "Only int16 is supported with AVX2");
             const __m256i lower_bound = _mm256_setzero_si256();
             const __m256i upper_bound = _mm256_set1_epi16(UPPER_BOUND);
@@ -39,6 +41,15 @@ namespace nn::activations {
         }
 #endif
 
+#ifdef KERNELS_AVX512
+        TARGET_AVX512 static __m512i _mm512_forward_epi16(__m512i value) {
+            static_assert(std::is_same_v<T, int16_t>, "Only int16 is supported with AVX-512");
+            const __m512i lower_bound = _mm512_setzero_si512();
+            const __m512i upper_bound = _mm512_set1_epi16(UPPER_BOUND);
+            return _mm512_min_epi16(_mm512_max_epi16(value, lower_bound), upper_bound);
+        }
+#endif
+
         static constexpr T backward(T value) {
             return static_cast<T>(0) < value && value < UPPER_BOUND;
         }
@@ -19,6 +19,8 @@
 
 #include "network.h"
 
+#include <memory>
+
 namespace nn {
 
     class Adam {
@@ -26,17 +28,26 @@ namespace nn {
         explicit Adam(float learning_rate) : LR(learning_rate), m_gradient(), v_gradient() {}
 
         void update(const std::vector<Gradient> &gradients, Network &network) {
-            Gradient total;
+            auto total = std::make_unique<Gradient>();
             for (const Gradient &g : gradients) {
-                total += g;
+                *total += g;
             }
 
-            update(network.l0.weights, m_gradient.l0.weights, v_gradient.l0.weights, total.l0.weights);
-            update(network.l0.biases, m_gradient.l0.biases, v_gradient.l0.biases, total.l0.biases);
+            update(network.l0.weights, m_gradient.l0.weights, v_gradient.l0.weights, total->l0.weights);
+            update(network.l0.biases, m_gradient.l0.biases, v_gradient.l0.biases, total->l0.biases);
 
             for (size_t i = 0; i < 2; i++) {
-                update(network.l1.layers[i].weights, m_gradient.l1.gradients[i].weights, v_gradient.l1.gradients[i].weights, total.l1.gradients[i].weights);
-                update(network.l1.layers[i].biases, m_gradient.l1.gradients[i].biases, v_gradient.l1.gradients[i].biases, total.l1.gradients[i].biases);
+                update(network.l1.layers[i].weights, m_gradient.l1.gradients[i].weights, v_gradient.l1.gradients[i].weights, total->l1.gradients[i].weights);
+                update(network.l1.layers[i].biases, m_gradient.l1.gradients[i].biases, v_gradient.l1.gradients[i].biases, total->l1.gradients[i].biases);
+            }
+
+            if (HIDDEN_LAYERS) {
+                for (size_t i = 0; i < 2; i++) {
+                    update(network.l2.layers[i].weights, m_gradient.l2.gradients[i].weights, v_gradient.l2.gradients[i].weights, total->l2.gradients[i].weights);
+                    update(network.l2.layers[i].biases, m_gradient.l2.gradients[i].biases, v_gradient.l2.gradients[i].biases, total->l2.gradients[i].biases);
+                    update(network.l3.layers[i].weights, m_gradient.l3.gradients[i].weights, v_gradient.l3.gradients[i].weights, total->l3.gradients[i].weights);
+                    update(network.l3.layers[i].biases, m_gradient.l3.gradients[i].biases, v_gradient.l3.gradients[i].biases, total->l3.gradients[i].biases);
+                }
             }
         }
 
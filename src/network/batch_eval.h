@@ -0,0 +1,170 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/board.h"
+#include "../chess/fen.h"
+#include "../utils/utilities.h"
+#include "eval.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace eval {
+
+    struct BatchCounts {
+        size_t evaluated = 0, invalid = 0;
+    };
+
+    // Statically evaluates large sets of positions, for labelling and filtering training data.
+    // Every thread keeps its own board and NNUE for the whole run.
+    class BatchEvaluator {
+
+    public:
+        static constexpr size_t BLOCK_SIZE = 1 << 12;
+
+        BatchEvaluator(const nn::NetworkRef &network, size_t thread_count) {
+            for (size_t id = 0; id < std::max<size_t>(thread_count, 1); id++) {
+                workers.emplace_back(std::make_unique<Worker>(network));
+            }
+        }
+
+        // Evaluates the position of fens[i] into scores[i], relative to the side to move.
+        // Anything after the first ';' of a FEN is ignored, invalid positions have no score.
+        void evaluate(const std::vector<std::string> &fens, std::vector<std::optional<Score>> &scores) {
+            scores.resize(fens.size());
+            const size_t slice = (fens.size() + workers.size() - 1) / workers.size();
+
+            std::vector<std::thread> threads;
+            for (size_t id = 0; id < workers.size(); id++) {
+                const size_t begin = std::min(id * slice, fens.size()), end = std::min(begin + slice, fens.size());
+                threads.emplace_back([&, id, begin, end]() {
+                    for (size_t i = begin; i < end; i++) {
+                        scores[i] = workers[id]->evaluate(fens[i]);
+                    }
+                });
+            }
+            for (std::thread &th : threads) {
+                th.join();
+            }
+        }
+
+        // Reads one position per line, in the format of the generated data or a plain FEN,
+        // and writes every valid line followed by its static evaluation as another ';' separated field.
+        // The threads are started once for the whole file. Each one reads a block of lines, evaluates it and writes it
+        // when the blocks before it are written, so the output keeps the order of the input.
+        // Returns the number of positions evaluated and of the invalid lines skipped.
+        BatchCounts evaluate_file(const std::string &input_path, const std::string &output_path) {
+            FileBatch batch{std::ifstream(input_path, std::ios::in), std::ofstream(output_path, std::ios::out)};
+            if (!batch.input.is_open() || !batch.output.is_open()) {
+                throw std::runtime_error("Unable to open: " + (batch.input.is_open() ? output_path : input_path));
+            }
+
+            std::vector<std::thread> threads;
+            for (size_t id = 0; id < workers.size(); id++) {
+                threads.emplace_back(evaluate_blocks, std::ref(*workers[id]), std::ref(batch));
+            }
+            for (std::thread &th : threads) {
+                th.join();
+            }
+
+            return batch.counts;
+        }
+
+    private:
+        struct Worker {
+            chess::Fen fen;
+            chess::Board board;
+            nn::NNUE nnue;
+
+            explicit Worker(const nn::NetworkRef &network) : nnue(network) {}
+
+            std::optional<Score> evaluate(std::string_view line) {
+                if (!chess::parse_fen(line.substr(0, line.find(';')), fen, false)) {
+                    return std::nullopt;
+                }
+                board.load(fen);
+                if (board.pieces<WHITE, KING>().pop_count() != 1 || board.pieces<BLACK, KING>().pop_count() != 1) {
+                    return std::nullopt;
+                }
+
+                nnue.refresh(board.to_features());
+                return eval::evaluate(board, nnue);
+            }
+        };
+
+        struct FileBatch {
+            std::ifstream input;
+            std::ofstream output;
+            std::mutex input_mutex, output_mutex;
+            std::condition_variable block_written;
+            size_t next_block = 0, written_blocks = 0;
+            BatchCounts counts;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        static void evaluate_blocks(Worker &worker, FileBatch &batch) {
+            std::vector<std::string> lines;
+            std::string block, line;
+
+            while (true) {
+                lines.clear();
+                size_t index;
+                {
+                    std::lock_guard<std::mutex> lock(batch.input_mutex);
+                    while (lines.size() < BLOCK_SIZE && std::getline(batch.input, line)) {
+                        if (!line.empty() && line.back() == '\r') line.pop_back();
+                        if (!line.empty()) lines.emplace_back(std::move(line));
+                    }
+                    if (lines.empty()) return;
+                    index = batch.next_block++;
+                }
+
+                block.clear();
+                size_t evaluated = 0;
+                for (const std::string &current : lines) {
+                    const std::optional<Score> score = worker.evaluate(current);
+                    if (!score) continue;
+                    block += current;
+                    if (current.back() != ';') block += ';';
+                    block += std::to_string(*score) + ";\n";
+                    evaluated++;
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock(batch.output_mutex);
+                    batch.block_written.wait(lock, [&batch, index]() { return batch.written_blocks == index; });
+                    batch.output << block;
+                    batch.written_blocks++;
+                    batch.counts.evaluated += evaluated;
+                    batch.counts.invalid += lines.size() - evaluated;
+                }
+                batch.block_written.notify_all();
+            }
+        }
+    };
+
+} // namespace eval
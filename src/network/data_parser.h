@@ -18,13 +18,16 @@
 #pragma once
 
 #include "../chess/constants.h"
+#include "../chess/packed_board.h"
 #include "../utils/utilities.h"
 #include "activations/sigmoid.h"
 #include "network.h"
 
+#include <charconv>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace nn {
@@ -36,60 +39,38 @@ namespace nn {
         float eval;
         Color stm;
 
-        explicit TrainingEntry(const std::string &entry) {
-            std::stringstream ss(entry);
-            unsigned int sq = 56, idx = 0;
+        explicit TrainingEntry(const chess::PackedBoard &board) {
+            Square squares[32];
+            Piece pieces[32];
+            const unsigned int count = chess::unpack_pieces(board, squares, pieces);
 
-            std::string s_fen, s_ply, s_bm, s_eval, s_wdl;
-            std::getline(ss, s_fen, ';');
-            std::getline(ss, s_ply, ';');
-            std::getline(ss, s_bm, ';');
-            std::getline(ss, s_eval, ';');
-            std::getline(ss, s_wdl, ';');
-
-            if (s_wdl == "1") {
-                wdl = 1.0f;
-            } else if (s_wdl == "0") {
-                wdl = 0.5f;
-            } else {
-                wdl = 0.0f;
+            // The features may depend on the squares of the kings, so they are collected after the whole board is decoded
+            unsigned int king_squares[2] = {};
+            for (unsigned int i = 0; i < count; i++) {
+                if (pieces[i].type == KING) king_squares[pieces[i].color] = squares[i];
             }
 
-            for (; idx < s_fen.size() && s_fen[idx] != ' '; idx++) {
-                char c = s_fen[idx];
-                if ('1' <= c && c <= '8') {
-                    sq += c - '0';
-                } else if (c == '/') {
-                    sq -= 16;
-                } else {
-                    Piece p = piece_from_char(c);
-                    white_features.emplace_back(Network::get_feature_index(p, sq));
-                    p.color = color_enemy(p.color);
-                    black_features.emplace_back(Network::get_feature_index(p, sq ^ 56));
-
-                    sq++;
-                }
+            white_features.reserve(count);
+            black_features.reserve(count);
+            for (unsigned int i = 0; i < count; i++) {
+                white_features.emplace_back(Network::get_feature_index(WHITE, pieces[i], squares[i], king_squares[WHITE]));
+                black_features.emplace_back(Network::get_feature_index(BLACK, pieces[i], squares[i], king_squares[BLACK]));
             }
 
-            idx++;
-            if (s_fen[idx] == 'w')
-                stm = WHITE;
-            else if (s_fen[idx] == 'b')
-                stm = BLACK;
-            else {
-                throw std::runtime_error("Invalid color specified in FEN " + entry + ".");
-            }
+            stm = Color(board.stm_ep >> 7);
+            wdl = float(board.result) / 2.0f;
 
-            int eval_int = std::stoi(s_eval);
+            int eval_int = board.eval;
             if (stm == BLACK) eval_int *= -1;
             eval = activations::sigmoid::forward(float(eval_int) / 400.0f);
         }
     };
 
+    // Reads the training data in either the text or the packed format, and provides the entries in the packed format.
     class DataParser {
     public:
-        explicit DataParser(const std::string &path) {
-            file.open(path, std::ios::in);
+        explicit DataParser(const std::string &path) : packed(chess::is_packed_data(path)) {
+            file.open(path, std::ios::in | (packed ? std::ios::binary : std::ios::openmode()));
 
             if (!file.is_open()) {
                 print("Unable to open:", path);
@@ -97,12 +78,10 @@ namespace nn {
             }
         }
 
-        void read_batch(size_t batch_size, std::string *lines, bool &is_new_epoch) {
-            std::string line;
+        // Reads the next batch_size entries, and starts over from the beginning of the file after the last one.
+        void read_batch(size_t batch_size, chess::PackedBoard *entries, bool &is_new_epoch) {
             for (size_t i = 0; i < batch_size; i++) {
-                if (std::getline(file, line)) {
-                    lines[i] = line;
-                } else {
+                if (!read_entry(entries[i])) {
                     i--;
                     file.clear();
                     file.seekg(0);
@@ -111,7 +90,71 @@ namespace nn {
             }
         }
 
+        // Counts the entries of a data file without parsing them.
+        static size_t count_entries(const std::string &path) {
+            if (chess::is_packed_data(path)) {
+                return std::filesystem::file_size(path) / sizeof(chess::PackedBoard);
+            }
+
+            size_t count = 0;
+            std::string tmp;
+            std::ifstream file(path, std::ios::in);
+            while (std::getline(file, tmp)) {
+                count++;
+            }
+            return count;
+        }
+
+        // Converts a line of the text format (fen;ply;best move;eval;wdl;) to the packed format.
+        static chess::PackedBoard parse_line(std::string_view line) {
+            std::string_view entry = line;
+            const std::string_view s_fen = next_field(entry);
+            const std::string_view s_ply = next_field(entry);
+            next_field(entry); // best move
+            const std::string_view s_eval = next_field(entry);
+            const std::string_view s_wdl = next_field(entry);
+
+            chess::Fen fen;
+            if (!chess::parse_fen(s_fen, fen, false)) {
+                throw std::runtime_error("Invalid FEN in entry " + std::string(line) + ".");
+            }
+            chess::PackedBoard board = chess::pack(fen);
+
+            if (s_wdl == "1") {
+                board.result = chess::PackedBoard::RESULT_WHITE_WIN;
+            } else if (s_wdl == "0") {
+                board.result = chess::PackedBoard::RESULT_DRAW;
+            } else {
+                board.result = chess::PackedBoard::RESULT_BLACK_WIN;
+            }
+
+            std::from_chars(s_ply.data(), s_ply.data() + s_ply.size(), board.ply);
+            std::from_chars(s_eval.data(), s_eval.data() + s_eval.size(), board.eval);
+            return board;
+        }
+
     private:
         std::ifstream file;
+        bool packed;
+        std::string line;
+
+        bool read_entry(chess::PackedBoard &entry) {
+            if (packed) {
+                return bool(file.read(reinterpret_cast<char *>(&entry), sizeof(entry)));
+            }
+            if (!std::getline(file, line)) {
+                return false;
+            }
+            entry = parse_line(line);
+            return true;
+        }
+
+        // Removes and returns the next ';' separated field of the entry.
+        static std::string_view next_field(std::string_view &entry) {
+            const size_t end = std::min(entry.find(';'), entry.size());
+            const std::string_view field = entry.substr(0, end);
+            entry.remove_prefix(std::min(end + 1, entry.size()));
+            return field;
+        }
     };
-} // namespace nn
\ No newline at end of file
+} // namespace nn
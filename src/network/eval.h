@@ -17,35 +17,87 @@
 
 #pragma once
 
+#include "../chess/bitbase.h"
 #include "../chess/board.h"
 #include "nnue.h"
 
 namespace eval {
 
-    Score get_eval_scale(const chess::Board &board) {
-        Score material_value = 0;
-        for (const PieceType pt : {KNIGHT, BISHOP, ROOK, QUEEN}) {
-            material_value += PIECE_VALUES[pt] * board.pieces(pt).pop_count();
+    Score get_eval_scale(chess::MaterialKey material) {
+        return 10000 + material.non_pawn_material();
+    }
+
+    // Won endings are scored above the other evaluations but below the mates
+    constexpr Score KNOWN_WIN = 3000;
+
+    // Rewards driving the lone king to the edge with the king of the stronger side close to it
+    Score get_mating_bonus(const chess::Board &board, Color strong) {
+        const Square strong_king = board.pieces<KING>(strong).lsb(), weak_king = board.pieces<KING>(color_enemy(strong)).lsb();
+        const int file = square_to_file(weak_king), rank = square_to_rank(weak_king);
+        const int edge = std::max(3 - file, file - 4) + std::max(3 - rank, rank - 4);
+        const int distance = std::max(std::abs(file - int(square_to_file(strong_king))), std::abs(rank - int(square_to_rank(strong_king))));
+        return Score(20 * edge + 10 * (7 - distance));
+    }
+
+    // Rewards the stronger side for making progress in a won bitbase ending: pushing the pawn, or mating the lone king.
+    Score get_progress_bonus(const chess::Board &board) {
+        const Square square = (board.occupied() ^ board.pieces<KING>()).lsb();
+        const Color strong = board.piece_at(square).color;
+
+        if (board.piece_at(square).type == PAWN) {
+            return 20 * Score(strong == WHITE ? square_to_rank(square) : 7 - square_to_rank(square));
         }
-        return 10000 + material_value;
+        return get_mating_bonus(board, strong);
     }
 
-    Score evaluate(const chess::Board &board, nn::NNUE &nnue) {
-        const int piece_count = board.occupied().pop_count();
+    bool has_opposite_bishops(const chess::Board &board) {
+        const chess::Bitboard bishops = board.pieces<BISHOP>();
+        return (bishops & chess::DARK_SQUARES) && (bishops & ~chess::DARK_SQUARES);
+    }
 
-        if (piece_count == 2) {
-            return 0;
-        } else if (piece_count == 3) {
+    // Positions that are drawn whatever the search finds, because neither side can mate or by the bitbases
+    bool is_known_draw(const chess::Board &board) {
+        const chess::MaterialEntry &entry = chess::probe_material(board.get_material());
+        return entry.kind == chess::MATERIAL_DRAW ||
+               (entry.kind == chess::MATERIAL_BITBASE && chess::bitbase::probe(board) == chess::bitbase::PROBE_DRAW);
+    }
 
-            const Piece piece = board.piece_at((board.occupied() ^ board.pieces<KING>()).lsb());
+    Score evaluate(const chess::Board &board, nn::NNUE &nnue) {
+        const chess::MaterialKey material = board.get_material();
+        const chess::MaterialEntry &entry = chess::probe_material(material);
 
-            if (piece.type == KNIGHT || piece.type == BISHOP) {
+        switch (entry.kind) {
+            case chess::MATERIAL_DRAW:
+            case chess::MATERIAL_DRAWISH:
                 return 0;
+            case chess::MATERIAL_WIN_WHITE:
+            case chess::MATERIAL_WIN_BLACK: {
+                // The material is counted too, so that the pawns are promoted
+                const Color strong = entry.kind == chess::MATERIAL_WIN_WHITE ? WHITE : BLACK;
+                const Score score = KNOWN_WIN + get_mating_bonus(board, strong) + material.material(strong) / 16;
+                return board.get_stm() == strong ? score : -score;
             }
+            case chess::MATERIAL_BITBASE:
+                switch (chess::bitbase::probe(board)) {
+                    case chess::bitbase::PROBE_DRAW:
+                        return 0;
+                    case chess::bitbase::PROBE_WIN:
+                        return KNOWN_WIN + get_progress_bonus(board);
+                    case chess::bitbase::PROBE_LOSS:
+                        return -KNOWN_WIN - get_progress_bonus(board);
+                    default:
+                        break;
+                }
+                break;
+            default:
+                break;
         }
 
         Score eval = nnue.evaluate(board.get_stm());
-        eval = (eval * get_eval_scale(board)) / 13000;
+        eval = (eval * get_eval_scale(material)) / 13000;
+        if (entry.scale != chess::SCALE_NORMAL && (!entry.opposite_bishops || has_opposite_bishops(board))) {
+            eval = eval * Score(entry.scale) / Score(chess::SCALE_NORMAL);
+        }
         eval = (eval * (200 - static_cast<int>(board.get_move50()))) / 200;
 
         return eval;
@@ -0,0 +1,82 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/constants.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace nn {
+
+    enum class FeatureSet : uint32_t {
+        PIECE_SQUARE = 0, // 768 inputs, one for each piece type of each color on each square
+        KING_BUCKETS = 1  // PIECE_SQUARE for each bucket of the own king, mirrored so that the own king is on the queen side
+    };
+
+    constexpr size_t KING_BUCKET_COUNT = 4;
+
+    // The bucket of each king square, seen from the side of the king.
+    // The buckets are symmetric, as the board is mirrored when the king is on files e-h.
+    constexpr std::array<unsigned int, 64> KING_BUCKETS = {
+            0, 0, 1, 1, 1, 1, 0, 0,
+            2, 2, 2, 2, 2, 2, 2, 2,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3,
+            3, 3, 3, 3, 3, 3, 3, 3};
+
+    constexpr size_t input_size(FeatureSet feature_set) {
+        return feature_set == FeatureSet::KING_BUCKETS ? 768 * KING_BUCKET_COUNT : 768;
+    }
+
+    // Groups the king squares of perspective that share the same features:
+    // two king squares give the same index if and only if they have the same bucket and mirroring.
+    constexpr unsigned int get_king_index(Color perspective, unsigned int king_sq) {
+        if (perspective == BLACK) king_sq ^= 56;
+        return KING_BUCKETS[king_sq] * 2 + (king_sq % 8 >= 4);
+    }
+
+    // Returns the index of piece on sq, as seen by perspective, whose king is on king_sq.
+    // The own pieces come after the enemy pieces, and the board is flipped vertically for black.
+    template<FeatureSet FEATURE_SET>
+    constexpr unsigned int get_feature_index(Color perspective, Piece piece, unsigned int sq, unsigned int king_sq) {
+        const unsigned int flip = perspective == WHITE ? 0 : 56;
+        unsigned int index = (piece.color == perspective) * 384 + piece.type * 64 + (sq ^ flip);
+        if constexpr (FEATURE_SET == FeatureSet::KING_BUCKETS) {
+            king_sq ^= flip;
+            if (king_sq % 8 >= 4) index ^= 7;
+            index += KING_BUCKETS[king_sq] * 768;
+        }
+        return index;
+    }
+
+    // Converts a PIECE_SQUARE feature seen by white into the same feature seen by black,
+    // that is with the colors swapped and the board flipped vertically.
+    constexpr unsigned int mirror_feature(unsigned int feature) {
+        return (feature < 384 ? feature + 384 : feature - 384) ^ 56;
+    }
+
+    static_assert(get_feature_index<FeatureSet::PIECE_SQUARE>(BLACK, Piece(KNIGHT, WHITE), B1, E8) == mirror_feature(get_feature_index<FeatureSet::PIECE_SQUARE>(WHITE, Piece(KNIGHT, WHITE), B1, E1)));
+    static_assert(get_feature_index<FeatureSet::KING_BUCKETS>(WHITE, Piece(PAWN, WHITE), H2, G1) == 384 + 64 + A2);
+    static_assert(get_feature_index<FeatureSet::KING_BUCKETS>(BLACK, Piece(PAWN, BLACK), A7, C8) == 768 + 384 + 64 + A2);
+
+} // namespace nn
@@ -18,30 +18,28 @@
 #pragma once
 
 #include "../../chess/constants.h"
+#include "../../utils/utilities.h"
 #include "../activations/none.h"
+#include "../simd.h"
 
 #include <array>
 #include <cstring>
 #include <fstream>
-#include <immintrin.h>
 #include <type_traits>
 #include <vector>
 
 namespace nn::layers {
 
-    template<size_t IN, size_t OUT, typename T, typename ACTIVATION = activations::none<T>>
-    class Accumulator {
-
-        static_assert(std::is_invocable_r_v<T, decltype(ACTIVATION::forward), T>, "Invalid ACTIVATION::forward");
-
-        static constexpr size_t register_width = 256 / (sizeof(T) * 8);
-        static constexpr size_t chunk_count = OUT / register_width;
+    // The read-only parameters of an accumulator, shared by every accumulator evaluating the same network.
+    template<size_t IN, size_t OUT, typename T>
+    struct AccumulatorWeights {
 
         static_assert(std::is_same_v<T, int16_t>, "Only int16 is supported for accumulators");
-        static_assert(256 % sizeof(T) == 0);
-        static_assert(OUT % register_width == 0);
+        static_assert(OUT % simd::MAX_WIDTH == 0);
+
+        alignas(64) std::array<T, OUT> biases;
+        alignas(64) std::array<T, IN * OUT> weights;
 
-    public:
         void load_from_file(std::ifstream &file) {
             file.read(reinterpret_cast<char *>(biases.data()), sizeof(biases));
             file.read(reinterpret_cast<char *>(weights.data()), sizeof(weights));
@@ -55,71 +53,92 @@ namespace nn::layers {
 
             return offset;
         }
+    };
+
+    template<size_t IN, size_t OUT, typename T, typename ACTIVATION = activations::none<T>>
+    class Accumulator {
+
+        static_assert(std::is_invocable_r_v<T, decltype(ACTIVATION::forward), T>, "Invalid ACTIVATION::forward");
+
+    public:
+        explicit Accumulator(const AccumulatorWeights<IN, OUT, T> &weights) : params(&weights) {}
+
+        void set_weights(const AccumulatorWeights<IN, OUT, T> &weights) {
+            params = &weights;
+        }
 
         void refresh(const std::vector<unsigned int> &features) {
-            reset();
-            for (unsigned int feature : features) {
-                add_feature(feature);
-            }
+            simd::accumulate_epi16<OUT>(accumulator.data(), params->biases.data(), params->weights.data(), features.data(), features.size());
         }
 
         void add_feature(unsigned int feature) {
-#ifdef AVX2
-            for (size_t i = 0; i < chunk_count; i++) {
-                const unsigned int offset = i * register_width;
-                __m256i base = _mm256_load_si256((__m256i *) &accumulator[offset]);
-                __m256i weight = _mm256_load_si256((__m256i *) &weights[feature * OUT + offset]);
-                _mm256_store_si256((__m256i *) &accumulator[offset], _mm256_add_epi16(base, weight));
-            }
-#else
-            for (size_t j = 0; j < OUT; j++) {
-                accumulator[j] += weights[feature * OUT + j];
-            }
-#endif
+            simd::add_epi16<OUT>(accumulator.data(), &params->weights[feature * OUT]);
         }
 
         void remove_feature(unsigned int feature) {
-#ifdef AVX2
-            for (size_t i = 0; i < chunk_count; i++) {
-                const size_t offset = i * register_width;
-                __m256i base = _mm256_load_si256((__m256i *) &accumulator[offset]);
-                __m256i weight = _mm256_load_si256((__m256i *) &weights[feature * OUT + offset]);
-                _mm256_store_si256((__m256i *) &accumulator[offset], _mm256_sub_epi16(base, weight));
-            }
-#else
-            for (size_t j = 0; j < OUT; j++) {
-                accumulator[j] -= weights[feature * OUT + j];
-            }
-#endif
+            simd::sub_epi16<OUT>(accumulator.data(), &params->weights[feature * OUT]);
         }
 
         void push(std::array<T, OUT> &result) {
-
-#ifdef AVX2
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wignored-attributes"
-            static_assert(std::is_invocable_r_v<__m256i, decltype(ACTIVATION::_mm256_forward_epi16), __m256i>, "ACTIVATION::forward doesn't support AVX2 registers");
-#pragma GCC diagnostic pop
-
-            for (size_t i = 0; i < chunk_count; i++) {
-                const size_t offset = i * register_width;
-                __m256i base = _mm256_load_si256((__m256i *) &accumulator[offset]);
-                _mm256_store_si256((__m256i *) &result[offset], ACTIVATION::_mm256_forward_epi16(base));
-            }
-#else
-            for (size_t i = 0; i < OUT; i++) {
-                result[i] = ACTIVATION::forward(accumulator[i]);
-            }
-#endif
+            simd::activate_epi16<OUT, ACTIVATION>(accumulator.data(), result.data());
         }
 
     private:
         alignas(64) std::array<T, OUT> accumulator;
-        alignas(64) std::array<T, OUT> biases;
-        alignas(64) std::array<T, IN * OUT> weights;
+        const AccumulatorWeights<IN, OUT, T> *params;
+    };
 
-        void reset() {
-            std::copy(biases.begin(), biases.end(), accumulator.begin());
+    // Accumulates the same weights from the perspective of both players.
+    template<size_t IN, size_t OUT, typename T, typename ACTIVATION = activations::none<T>>
+    class DualAccumulator {
+
+        static_assert(std::is_invocable_r_v<T, decltype(ACTIVATION::forward), T>, "Invalid ACTIVATION::forward");
+
+    public:
+        explicit DualAccumulator(const AccumulatorWeights<IN, OUT, T> &weights) : params(&weights) {}
+
+        void refresh(const std::vector<unsigned int> &white_features, const std::vector<unsigned int> &black_features) {
+            simd::accumulate_epi16<OUT>(accumulators[WHITE].data(), params->biases.data(), params->weights.data(), white_features.data(), white_features.size());
+            simd::accumulate_epi16<OUT>(accumulators[BLACK].data(), params->biases.data(), params->weights.data(), black_features.data(), black_features.size());
+        }
+
+        void add_feature(unsigned int white_feature, unsigned int black_feature) {
+            simd::add2_epi16<OUT>(accumulators[WHITE].data(), &params->weights[white_feature * OUT],
+                                  accumulators[BLACK].data(), &params->weights[black_feature * OUT]);
+        }
+
+        void remove_feature(unsigned int white_feature, unsigned int black_feature) {
+            simd::sub2_epi16<OUT>(accumulators[WHITE].data(), &params->weights[white_feature * OUT],
+                                  accumulators[BLACK].data(), &params->weights[black_feature * OUT]);
+        }
+
+        void add_feature(Color perspective, unsigned int feature) {
+            simd::add_epi16<OUT>(accumulators[perspective].data(), &params->weights[feature * OUT]);
+        }
+
+        void remove_feature(Color perspective, unsigned int feature) {
+            simd::sub_epi16<OUT>(accumulators[perspective].data(), &params->weights[feature * OUT]);
         }
+
+        // Replaces the accumulator of perspective with previously accumulated values.
+        void load(Color perspective, const std::array<T, OUT> &values) {
+            accumulators[perspective] = values;
+        }
+
+        // Activates the accumulator of the side to move first, followed by the other one.
+        void push(Color stm, std::array<T, 2 * OUT> &result) {
+            simd::activate_epi16<OUT, ACTIVATION>(accumulators[stm].data(), result.data());
+            simd::activate_epi16<OUT, ACTIVATION>(accumulators[color_enemy(stm)].data(), result.data() + OUT);
+        }
+
+        // Same as above, but into the uint8 input of int8 layers.
+        void push(Color stm, std::array<uint8_t, 2 * OUT> &result) {
+            simd::activate_epu8<OUT, ACTIVATION>(accumulators[stm].data(), result.data());
+            simd::activate_epu8<OUT, ACTIVATION>(accumulators[color_enemy(stm)].data(), result.data() + OUT);
+        }
+
+    private:
+        alignas(64) std::array<std::array<T, OUT>, 2> accumulators;
+        const AccumulatorWeights<IN, OUT, T> *params;
     };
 } // namespace nn::layers
\ No newline at end of file
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "../activations/none.h"
+#include "../simd.h"
 
 namespace nn::layers {
 
@@ -111,10 +112,11 @@ namespace nn::layers {
             file.write(reinterpret_cast<char *>(weights.data()), sizeof(weights));
         }
 
-        template<typename QTYPE, int QBIAS_SCALE, int QWEIGHT_SCALE>
-        void quantize(std::ofstream &file) {
-            std::array<QTYPE, OUT> qbiases;
-            std::array<QTYPE, IN * OUT> qweights;
+        // The biases are written as QBIAS_TYPE, since they are usually on a larger scale than the weights.
+        template<typename QTYPE, int QBIAS_SCALE, int QWEIGHT_SCALE, typename QBIAS_TYPE = QTYPE>
+        void quantize(std::ostream &file) {
+            std::array<QBIAS_TYPE, OUT> qbiases;
+            std::vector<QTYPE> qweights(IN * OUT);
             for (size_t i = 0; i < OUT; i++) {
                 qbiases[i] = round(biases[i] * QBIAS_SCALE);
             }
@@ -123,7 +125,7 @@ namespace nn::layers {
             }
 
             file.write(reinterpret_cast<char *>(qbiases.data()), sizeof(qbiases));
-            file.write(reinterpret_cast<char *>(qweights.data()), sizeof(qweights));
+            file.write(reinterpret_cast<char *>(qweights.data()), sizeof(QTYPE) * qweights.size());
         }
 
         void forward(const std::vector<unsigned int> &input_features, std::array<T2, OUT> &output) const {
@@ -140,6 +142,12 @@ namespace nn::layers {
         }
 
         void forward(const std::array<T, IN> &input, std::array<T2, OUT> &output) const {
+            if constexpr (std::is_same_v<T, int16_t> && std::is_same_v<T2, int32_t> && OUT == 1) {
+                output[0] = biases[0] + simd::dot_epi16<IN>(input.data(), weights.data());
+                activate(output);
+                return;
+            }
+
             for (size_t i = 0; i < OUT; i++) {
                 output[i] = biases[i];
             }
@@ -68,10 +68,10 @@ namespace nn::layers {
             }
         }
 
-        template<typename QTYPE, int QBIAS_SCALE, int QWEIGHT_SCALE>
-        void quantize(std::ofstream &file) {
+        template<typename QTYPE, int QBIAS_SCALE, int QWEIGHT_SCALE, typename QBIAS_TYPE = QTYPE>
+        void quantize(std::ostream &file) {
             for (size_t i = 0; i < BUCKETS; i++) {
-                layers[i].template quantize<QTYPE, QBIAS_SCALE, QWEIGHT_SCALE>(file);
+                layers[i].template quantize<QTYPE, QBIAS_SCALE, QWEIGHT_SCALE, QBIAS_TYPE>(file);
             }
         }
 
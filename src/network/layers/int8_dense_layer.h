@@ -0,0 +1,124 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../simd.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+namespace nn::layers {
+
+    // A quantized dense layer with uint8 inputs, int8 weights and int32 outputs.
+    // The weights are stored in the order expected by simd::affine_epu8_epi8, a single output is a plain dot product.
+    template<size_t IN, size_t OUT>
+    struct Int8DenseLayer {
+
+        static_assert(OUT == 1 ? IN % 32 == 0 : IN % 4 == 0 && OUT % 16 == 0);
+
+        alignas(64) std::array<int32_t, OUT> biases;
+        alignas(64) std::array<int8_t, IN * OUT> weights;
+
+        // Loads the layout written by DenseLayer::quantize<int8_t, ..., int32_t>, where the weights are ordered by input.
+        int load_from_pointer(const unsigned char *ptr, int offset) {
+            std::memcpy(biases.data(), ptr + offset, sizeof(int32_t) * OUT);
+            offset += sizeof(int32_t) * OUT;
+
+            for (size_t i = 0; i < IN; i++) {
+                for (size_t j = 0; j < OUT; j++) {
+                    weights[(i / 4) * OUT * 4 + j * 4 + i % 4] = static_cast<int8_t>(ptr[offset++]);
+                }
+            }
+
+            return offset;
+        }
+
+        void forward(const uint8_t *input, int32_t *output) const {
+            if constexpr (OUT == 1) {
+                output[0] = biases[0] + simd::dot_epu8_epi8<IN>(input, weights.data());
+            } else {
+                simd::affine_epu8_epi8<IN, OUT>(input, weights.data(), biases.data(), output);
+            }
+        }
+
+        // Only reads the count groups of 4 inputs listed in nnz, every other input has to be zero.
+        void forward_sparse(const uint8_t *input, const uint16_t *nnz, size_t count, int32_t *output) const {
+            static_assert(OUT != 1);
+            simd::affine_sparse_epu8_epi8<IN, OUT>(input, nnz, count, weights.data(), biases.data(), output);
+        }
+    };
+
+    // The L1->L2->L3->1 layers following the accumulator, bucketed like DenseLayerBucket.
+    // Every layer works on the scale of the accumulator, QSCALE represents 1.0 for inputs and weights,
+    // and the hidden outputs are clipped into [0, QSCALE], so they fit into uint8.
+    template<size_t BUCKETS, size_t L1, size_t L2, size_t L3, int QSCALE>
+    struct Int8HiddenLayers {
+
+        static_assert(QSCALE < 128, "The inputs of the hidden layers have to fit into [0, 127]");
+        static_assert(L1 % 64 == 0, "The non-zero inputs are searched in whole registers");
+
+        // The sparse kernel is faster while at most 3/4 of the groups of inputs are non-zero
+        static constexpr size_t SPARSE_GROUPS = L1 / 4 * 3 / 4;
+
+        std::array<Int8DenseLayer<L1, L2>, BUCKETS> l1;
+        std::array<Int8DenseLayer<L2, L3>, BUCKETS> l2;
+        std::array<Int8DenseLayer<L3, 1>, BUCKETS> l3;
+
+        int load_from_pointer(const unsigned char *ptr, int offset) {
+            for (auto &layer : l1) offset = layer.load_from_pointer(ptr, offset);
+            for (auto &layer : l2) offset = layer.load_from_pointer(ptr, offset);
+            for (auto &layer : l3) offset = layer.load_from_pointer(ptr, offset);
+            return offset;
+        }
+
+        // Returns the output on the scale of QSCALE * QSCALE.
+        void forward(size_t bucket_index, const std::array<uint8_t, L1> &input, std::array<int32_t, 1> &output) const {
+            assert(bucket_index < BUCKETS);
+
+            alignas(64) std::array<int32_t, L2> l1_output;
+            alignas(64) std::array<int32_t, L3> l2_output;
+            alignas(64) std::array<uint8_t, L2> l2_input;
+            alignas(64) std::array<uint8_t, L3> l3_input;
+            alignas(64) std::array<uint16_t, L1 / 4> nnz;
+
+            // Most of the activated accumulator is usually clipped to zero, so the first layer only reads the groups of 4 inputs
+            // containing a non-zero input. Reading the groups through their indices is slower, so dense inputs use the dense kernel.
+            const size_t count = simd::find_nnz<L1>(input.data(), nnz.data());
+            if (count <= SPARSE_GROUPS) {
+                l1[bucket_index].forward_sparse(input.data(), nnz.data(), count, l1_output.data());
+            } else {
+                l1[bucket_index].forward(input.data(), l1_output.data());
+            }
+            activate<L2>(l1_output.data(), l2_input.data());
+            l2[bucket_index].forward(l2_input.data(), l2_output.data());
+            activate<L3>(l2_output.data(), l3_input.data());
+            l3[bucket_index].forward(l3_input.data(), output.data());
+        }
+
+    private:
+        template<size_t N>
+        static void activate(const int32_t *input, uint8_t *output) {
+            for (size_t i = 0; i < N; i++) {
+                output[i] = std::clamp(input[i] / QSCALE, 0, QSCALE);
+            }
+        }
+    };
+
+} // namespace nn::layers
@@ -20,37 +20,94 @@
 #include "activations/crelu.h"
 #include "activations/relu.h"
 #include "activations/sigmoid.h"
+#include "features.h"
 #include "layers/dense_layer.h"
 #include "layers/dense_layer_bucket.h"
+#include "network_file.h"
+
+#include <sstream>
 
 namespace nn {
 
+    // Hidden layer size of the trained network, it has to be one of the sizes in nn::Architectures to be quantized.
     constexpr size_t L1_SIZE = 512;
 
+    // 1 trains a network evaluating from white's point of view, 2 trains a network with accumulators
+    // for both sides, ordered by the side to move.
+    constexpr size_t PERSPECTIVES = 1;
+
+    // The input features of the trained network, KING_BUCKETS requires two perspectives.
+    constexpr FeatureSet FEATURE_SET = FeatureSet::PIECE_SQUARE;
+
+    constexpr size_t INPUT_SIZE = input_size(FEATURE_SET);
+
+    static_assert(FEATURE_SET == FeatureSet::PIECE_SQUARE || PERSPECTIVES == 2);
+
+    // true trains the hidden layers L1->L2->L3->1, which are quantized to int8, instead of a single output layer.
+    // It requires two perspectives, and the sizes have to match one of nn::Architectures.
+    constexpr bool HIDDEN_LAYERS = false;
+    constexpr size_t L2_SIZE = 16;
+    constexpr size_t L3_SIZE = 32;
+
+    static_assert(!HIDDEN_LAYERS || PERSPECTIVES == 2);
+
+    // Without hidden layers l1 is the output layer, and l2 and l3 are unused.
+    constexpr size_t L1_OUTPUT_SIZE = HIDDEN_LAYERS ? L2_SIZE : 1;
+
     struct Gradient {
-        layers::DenseLayerGradient<768, L1_SIZE> l0;
-        layers::DenseLayerBucketGradient<2, L1_SIZE, 1> l1;
+        layers::DenseLayerGradient<INPUT_SIZE, L1_SIZE> l0;
+        layers::DenseLayerBucketGradient<2, L1_SIZE * PERSPECTIVES, L1_OUTPUT_SIZE> l1;
+        layers::DenseLayerBucketGradient<2, L1_OUTPUT_SIZE, L3_SIZE> l2;
+        layers::DenseLayerBucketGradient<2, L3_SIZE, 1> l3;
 
         Gradient() = default;
 
         void operator+=(const Gradient &g) {
             l0 += g.l0;
             l1 += g.l1;
+            if (HIDDEN_LAYERS) {
+                l2 += g.l2;
+                l3 += g.l3;
+            }
+        }
+    };
+
+    // The outputs of every layer, kept from the forward pass for the backward pass.
+    struct LayerOutputs {
+        std::array<float, L1_SIZE * PERSPECTIVES> l0;
+        std::array<float, L1_OUTPUT_SIZE> l1;
+        std::array<float, L3_SIZE> l2;
+        std::array<float, 1> l3;
+
+        [[nodiscard]] float prediction() const {
+            return HIDDEN_LAYERS ? l3[0] : l1[0];
         }
     };
 
     struct Network {
 
-        static constexpr int MAGIC = 6;
+        static constexpr int MAGIC = (FEATURE_SET == FeatureSet::KING_BUCKETS ? 8 : PERSPECTIVES == 2 ? 7 : 6) + (HIDDEN_LAYERS ? 3 : 0);
 
-        static constexpr unsigned int get_feature_index(Piece piece, unsigned int sq) {
-            return (piece.color == WHITE) * 384 + piece.type * 64 + sq;
+        static constexpr unsigned int get_feature_index(Color perspective, Piece piece, unsigned int sq, unsigned int king_sq) {
+            return nn::get_feature_index<FEATURE_SET>(perspective, piece, sq, king_sq);
         }
 
-        layers::DenseLayer<768, L1_SIZE, float, float, activations::crelu<float, 1>> l0;
-        layers::DenseLayerBucket<2, L1_SIZE, 1, float, float, activations::sigmoid> l1;
+        layers::DenseLayer<INPUT_SIZE, L1_SIZE, float, float, activations::crelu<float, 1>> l0;
+        layers::DenseLayerBucket<2, L1_SIZE * PERSPECTIVES, L1_OUTPUT_SIZE, float, float,
+                                 std::conditional_t<HIDDEN_LAYERS, activations::crelu<float, 1>, activations::sigmoid>>
+                l1;
+        layers::DenseLayerBucket<2, L1_OUTPUT_SIZE, L3_SIZE, float, float, activations::crelu<float, 1>> l2;
+        layers::DenseLayerBucket<2, L3_SIZE, 1, float, float, activations::sigmoid> l3;
 
         Network(const std::string &network_path) {
+            load(network_path);
+        }
+
+        Network() {
+            randomize();
+        }
+
+        void load(const std::string &network_path) {
             std::ifstream file(network_path, std::ios::in | std::ios::binary);
             if (!file.is_open()) {
                 print("Unable to open: ", network_path);
@@ -68,24 +125,63 @@ namespace nn {
 
             l0.load_from_file(file);
             l1.load_from_file(file);
+            if (HIDDEN_LAYERS) {
+                l2.load_from_file(file);
+                l3.load_from_file(file);
+            }
 
             print("Loaded network file: ", network_path);
         }
 
-        Network() {
-            randomize();
-        }
-
         void randomize() {
             std::random_device rd;
             std::mt19937 mt(rd());
             l0.randomize(mt);
             l1.randomize(mt);
+            l2.randomize(mt);
+            l3.randomize(mt);
+        }
+
+        // With two perspectives the hidden layer of the side to move comes first.
+        static bool is_white_perspective(size_t perspective, Color stm) {
+            return PERSPECTIVES == 1 || (perspective == 0) == (stm == WHITE);
         }
 
-        void forward(const std::vector<unsigned int> &features, std::array<float, L1_SIZE> &l0_output, std::array<float, 1> &l1_output, Color stm) const {
-            l0.forward(features, l0_output);
-            l1.forward(stm, l0_output, l1_output);
+        void forward(const std::vector<unsigned int> &white_features, const std::vector<unsigned int> &black_features,
+                     LayerOutputs &outputs, Color stm) const {
+            std::array<float, L1_SIZE> output;
+            for (size_t perspective = 0; perspective < PERSPECTIVES; perspective++) {
+                l0.forward(is_white_perspective(perspective, stm) ? white_features : black_features, output);
+                std::copy(output.begin(), output.end(), outputs.l0.begin() + perspective * L1_SIZE);
+            }
+            l1.forward(stm, outputs.l0, outputs.l1);
+            if (HIDDEN_LAYERS) {
+                l2.forward(stm, outputs.l1, outputs.l2);
+                l3.forward(stm, outputs.l2, outputs.l3);
+            }
+        }
+
+        // Accumulates the gradient of loss, which is the derivative of the error with respect to the prediction.
+        void backward(const std::vector<unsigned int> &white_features, const std::vector<unsigned int> &black_features,
+                      const LayerOutputs &outputs, float loss, Color stm, Gradient &gradient) const {
+            std::array<float, L1_OUTPUT_SIZE> l1_loss;
+            if (HIDDEN_LAYERS) {
+                std::array<float, L3_SIZE> l2_loss;
+                l3.backward(stm, {loss}, outputs.l2, outputs.l3, l2_loss, gradient.l3);
+                l2.backward(stm, l2_loss, outputs.l1, outputs.l2, l1_loss, gradient.l2);
+            } else {
+                l1_loss[0] = loss;
+            }
+
+            std::array<float, L1_SIZE * PERSPECTIVES> l0_loss;
+            l1.backward(stm, l1_loss, outputs.l0, outputs.l1, l0_loss, gradient.l1);
+
+            std::array<float, L1_SIZE> perspective_loss, output;
+            for (size_t perspective = 0; perspective < PERSPECTIVES; perspective++) {
+                std::copy(l0_loss.begin() + perspective * L1_SIZE, l0_loss.begin() + (perspective + 1) * L1_SIZE, perspective_loss.begin());
+                std::copy(outputs.l0.begin() + perspective * L1_SIZE, outputs.l0.begin() + (perspective + 1) * L1_SIZE, output.begin());
+                l0.backward(perspective_loss, is_white_perspective(perspective, stm) ? white_features : black_features, output, gradient.l0);
+            }
         }
 
         void write_to_file(const std::string &output_path) {
@@ -100,25 +196,35 @@ namespace nn {
 
             l0.write_to_file(file);
             l1.write_to_file(file);
+            if (HIDDEN_LAYERS) {
+                l2.write_to_file(file);
+                l3.write_to_file(file);
+            }
 
             file.close();
         }
 
         template<typename QTYPE, int QSCALE>
         void quantize(const std::string &output_path) {
-            std::ofstream file(output_path, std::ios::out | std::ios::binary);
-            if (!file.is_open()) {
-                print("Unable to open:", output_path);
-                throw std::runtime_error("Unable to open: " + output_path);
-            }
+            std::stringstream buffer;
 
             int magic = -MAGIC;
-            file.write(reinterpret_cast<char *>(&magic), sizeof(magic));
-
-            l0.quantize<QTYPE, QSCALE, QSCALE>(file);
-            l1.quantize<QTYPE, QSCALE * QSCALE, QSCALE>(file);
+            buffer.write(reinterpret_cast<char *>(&magic), sizeof(magic));
+
+            l0.quantize<QTYPE, QSCALE, QSCALE>(buffer);
+            if (HIDDEN_LAYERS) {
+                // The hidden layers take the activated accumulator as uint8, their outputs keep the scale of their inputs
+                l1.quantize<int8_t, QSCALE * QSCALE, QSCALE, int32_t>(buffer);
+                l2.quantize<int8_t, QSCALE * QSCALE, QSCALE, int32_t>(buffer);
+                l3.quantize<int8_t, QSCALE * QSCALE, QSCALE, int32_t>(buffer);
+            } else {
+                l1.quantize<QTYPE, QSCALE * QSCALE, QSCALE>(buffer);
+            }
 
-            file.close();
+            const std::string data = buffer.str();
+            auto network = std::make_unique<QuantizedNetwork<L1_SIZE, PERSPECTIVES, FEATURE_SET, HIDDEN_LAYERS ? L2_SIZE : 0, HIDDEN_LAYERS ? L3_SIZE : 0>>();
+            network->load_packed(reinterpret_cast<const unsigned char *>(data.data()), data.size());
+            write_network(*network, output_path);
         }
     };
 } // namespace nn
\ No newline at end of file
@@ -0,0 +1,138 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../external/incbin/incbin.h"
+#include "../utils/mapped_file.h"
+#include "../utils/utilities.h"
+#include "quantized_network.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+namespace nn {
+
+    INCBIN(DefaultNetwork, "tmp.bin");
+
+    [[nodiscard]] bool is_network_file(const unsigned char *data, size_t size) {
+        uint32_t magic = 0;
+        std::memcpy(&magic, data, std::min(sizeof(magic), size));
+        return magic == NetworkHeader::MAGIC;
+    }
+
+    // Checks the header of a network file, and returns the network image following it.
+    NetworkRef validate_network_file(const unsigned char *data, size_t size) {
+        NetworkHeader header;
+        if (size < sizeof(header)) {
+            throw std::invalid_argument("Truncated network header");
+        }
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.magic != NetworkHeader::MAGIC) {
+            throw std::invalid_argument("Invalid network file with magic " + std::to_string(header.magic));
+        }
+        if (header.version != NetworkHeader::FORMAT_VERSION) {
+            throw std::invalid_argument("Unsupported network version " + std::to_string(header.version));
+        }
+        if (size != sizeof(NetworkHeader) + header.payload_size) {
+            throw std::invalid_argument("Invalid network size " + std::to_string(size) + ", expected " +
+                                        std::to_string(sizeof(NetworkHeader) + header.payload_size));
+        }
+
+        std::optional<NetworkRef> network = Architectures::from_payload(header, data + sizeof(NetworkHeader));
+        if (!network) {
+            throw std::invalid_argument("Unsupported network architecture: " + header.describe());
+        }
+        return *network;
+    }
+
+    template<typename NETWORK>
+    void write_network(const NETWORK &network, const std::string &output_path) {
+        std::ofstream file(output_path, std::ios::out | std::ios::binary);
+        if (!file.is_open()) {
+            print("Unable to open:", output_path);
+            throw std::runtime_error("Unable to open: " + output_path);
+        }
+
+        const NetworkHeader header = NETWORK::get_header();
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(&network), sizeof(network));
+    }
+
+    // A loaded network. Network files on disk are used directly from the mapping,
+    // everything else is copied into aligned memory.
+    class LoadedNetwork {
+    public:
+        explicit LoadedNetwork(const std::string &path) : file(path) {
+            if (is_network_file(file.data(), file.size())) {
+                // The mapping is page aligned, and the header keeps the payload 64 byte aligned
+                network = validate_network_file(file.data(), file.size());
+            } else {
+                copy_from(file.data(), file.size());
+                file = MappedFile();
+            }
+        }
+
+        LoadedNetwork(const unsigned char *data, size_t size) {
+            copy_from(data, size);
+        }
+
+        [[nodiscard]] const NetworkRef &get() const {
+            return network;
+        }
+
+        [[nodiscard]] bool is_mapped() const {
+            return copy == nullptr;
+        }
+
+        [[nodiscard]] std::string describe() const {
+            return std::visit([](auto *params) { return std::decay_t<decltype(*params)>::get_header().describe(); }, network);
+        }
+
+    private:
+        MappedFile file;
+        std::shared_ptr<const void> copy;
+        NetworkRef network;
+
+        void copy_from(const unsigned char *data, size_t size) {
+            if (is_network_file(data, size)) {
+                const NetworkRef image = validate_network_file(data, size);
+                std::visit([&](auto *params) {
+                    using NETWORK = std::decay_t<decltype(*params)>;
+                    std::shared_ptr<NETWORK> result(new NETWORK());
+                    std::memcpy(static_cast<void *>(result.get()), params, sizeof(NETWORK));
+                    network = result.get();
+                    copy = result;
+                }, image);
+            } else {
+                std::shared_ptr<PackedNetwork> result(new PackedNetwork());
+                result->load_packed(data, size);
+                network = result.get();
+                copy = result;
+            }
+        }
+    };
+
+    // The embedded network, copied into aligned memory on first use.
+    const NetworkRef &get_default_network() {
+        static const LoadedNetwork network(gDefaultNetworkData, gDefaultNetworkSize);
+        return network.get();
+    }
+
+} // namespace nn
@@ -17,100 +17,274 @@
 
 #pragma once
 
+#include "../chess/bitboard.h"
 #include "../chess/constants.h"
-#include "../external/incbin/incbin.h"
-#include "../utils/utilities.h"
 #include "activations/crelu.h"
+#include "features.h"
 #include "layers/accumulator.h"
-#include "layers/dense_layer_bucket.h"
+#include "network_file.h"
+#include "quantized_network.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <variant>
 
 namespace nn {
 
-    INCBIN(DefaultNetwork, "tmp.bin");
+    // The inference state of a single thread, specialized for one architecture.
+    template<typename NETWORK>
+    class Evaluator {
 
-    class NNUE {
+    public:
+        static constexpr int QSCALE = NETWORK::QSCALE;
+
+        explicit Evaluator(const NETWORK &network) : params(&network), accumulator(network.accumulator) {}
+
+        void refresh(const std::vector<unsigned int> &features) {
+            if constexpr (PERSPECTIVES == 2) {
+                std::vector<unsigned int> black_features(features.size());
+                std::transform(features.begin(), features.end(), black_features.begin(), mirror_feature);
+                accumulator.refresh(features, black_features);
+            } else {
+                accumulator.refresh(features);
+            }
+        }
+
+        void activate(Piece piece, unsigned int sq) {
+            const unsigned int feature = get_feature_index<FeatureSet::PIECE_SQUARE>(WHITE, piece, sq, 0);
+            if constexpr (PERSPECTIVES == 2) {
+                accumulator.add_feature(feature, mirror_feature(feature));
+            } else {
+                accumulator.add_feature(feature);
+            }
+        }
+
+        void deactivate(Piece piece, unsigned int sq) {
+            const unsigned int feature = get_feature_index<FeatureSet::PIECE_SQUARE>(WHITE, piece, sq, 0);
+            if constexpr (PERSPECTIVES == 2) {
+                accumulator.remove_feature(feature, mirror_feature(feature));
+            } else {
+                accumulator.remove_feature(feature);
+            }
+        }
+
+        Score evaluate(Color stm) {
+            int32_t score;
+            if constexpr (PERSPECTIVES == 2) {
+                accumulator.push(stm, l0_output);
+                params->l1.forward(stm, l0_output, l1_output);
+                score = l1_output[0];
+            } else {
+                accumulator.push(l0_output);
+                params->l1.forward(stm, l0_output, l1_output);
+                score = l1_output[0];
+                if (stm == BLACK) score *= -1;
+            }
+            return (score * 400) / (QSCALE * QSCALE);
+        }
+
+    private:
+        static constexpr size_t L1_SIZE = NETWORK::L1_SIZE;
+        static constexpr size_t PERSPECTIVES = NETWORK::PERSPECTIVES;
+
+        using Activation = activations::crelu<int16_t, QSCALE>;
+
+        alignas(64) std::array<typename NETWORK::L1Input, L1_SIZE * PERSPECTIVES> l0_output;
+        alignas(64) std::array<int32_t, 1> l1_output;
+
+        const NETWORK *params;
+        std::conditional_t<PERSPECTIVES == 2,
+                           layers::DualAccumulator<NETWORK::INPUT_SIZE, L1_SIZE, int16_t, Activation>,
+                           layers::Accumulator<NETWORK::INPUT_SIZE, L1_SIZE, int16_t, Activation>>
+                accumulator;
+    };
+
+    // The inference state of a single thread for king bucketed networks.
+    //
+    // When a king moves to another bucket, every feature of its perspective changes. Instead of updating it, the perspective
+    // is marked dirty, and it is rebuilt before the next evaluation from a cache holding the last accumulator of each bucket,
+    // by applying only the pieces that differ since then.
+    template<typename NETWORK>
+    class KingBucketEvaluator {
 
     public:
-        static constexpr int QSCALE = 64;
+        static constexpr int QSCALE = NETWORK::QSCALE;
 
-        NNUE() {
-            const unsigned char *data = gDefaultNetworkData;
+        explicit KingBucketEvaluator(const NETWORK &network) : params(&network), accumulator(network.accumulator) {
+            for (auto &entries : cache) {
+                for (CacheEntry &entry : entries) {
+                    entry.accumulator = network.accumulator.biases;
+                }
+            }
+        }
 
-            int magic;
-            std::memcpy(&magic, data, sizeof(int));
-            int offset = sizeof(int);
+        // Refreshes from PIECE_SQUARE features, as returned by Board::to_features.
+        void refresh(const std::vector<unsigned int> &features) {
+            pieces = {};
+            for (unsigned int feature : features) {
+                const Piece piece(index_to_type[feature % 384 / 64], feature >= 384 ? WHITE : BLACK);
+                const auto sq = Square(feature % 64);
+                pieces[get_piece_index(piece)].set(sq);
+                if (piece.type == KING) king_squares[piece.color] = sq;
+            }
+            refresh(WHITE);
+            refresh(BLACK);
+        }
 
-            if (magic != MAGIC) {
-                print("Invalid default network file with magic", magic);
-                throw std::invalid_argument("Invalid default network file with magic" + std::to_string(magic));
+        void activate(Piece piece, unsigned int sq) {
+            pieces[get_piece_index(piece)].set(Square(sq));
+            if (piece.type == KING) {
+                dirty[piece.color] |= get_king_index(piece.color, sq) != get_king_index(piece.color, king_squares[piece.color]);
+                king_squares[piece.color] = sq;
             }
+            update<true>(piece, sq);
+        }
 
-            offset = accumulator.load_from_pointer(data, offset);
-            offset = l1.load_from_pointer(data, offset);
+        void deactivate(Piece piece, unsigned int sq) {
+            pieces[get_piece_index(piece)].clear(Square(sq));
+            update<false>(piece, sq);
+        }
 
-            assert(offset == gDefaultNetworkSize);
+        Score evaluate(Color stm) {
+            if (dirty[WHITE]) refresh(WHITE);
+            if (dirty[BLACK]) refresh(BLACK);
+
+            accumulator.push(stm, l0_output);
+            params->l1.forward(stm, l0_output, l1_output);
+            return (l1_output[0] * 400) / (QSCALE * QSCALE);
         }
 
-        /*void load_from_file(const std::string &nnue_path) {
-            std::ifstream file(nnue_path, std::ios::in | std::ios::binary);
-            if (!file.is_open()) {
-                logger.print("Unable to open:", nnue_path);
-                throw std::invalid_argument("Unable to open: " + nnue_path);
-            } else {
-                int magic;
-                file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    private:
+        static constexpr FeatureSet FEATURE_SET = NETWORK::FEATURE_SET;
+        static constexpr size_t L1_SIZE = NETWORK::L1_SIZE;
+
+        static_assert(FEATURE_SET == FeatureSet::KING_BUCKETS);
+        static_assert(NETWORK::PERSPECTIVES == 2);
+
+        using Activation = activations::crelu<int16_t, QSCALE>;
+
+        struct CacheEntry {
+            alignas(64) std::array<int16_t, L1_SIZE> accumulator;
+            std::array<chess::Bitboard, 12> pieces{};
+        };
+
+        alignas(64) std::array<typename NETWORK::L1Input, L1_SIZE * 2> l0_output;
+        alignas(64) std::array<int32_t, 1> l1_output;
+
+        const NETWORK *params;
+        layers::DualAccumulator<NETWORK::INPUT_SIZE, L1_SIZE, int16_t, Activation> accumulator;
+
+        std::array<chess::Bitboard, 12> pieces{};
+        std::array<unsigned int, 2> king_squares{};
+        std::array<bool, 2> dirty{};
+        std::array<std::array<CacheEntry, KING_BUCKET_COUNT * 2>, 2> cache;
+
+        static constexpr unsigned int get_piece_index(Piece piece) {
+            return piece.color * 6 + piece.type;
+        }
 
-                if (magic != MAGIC) {
-                    logger.print("Invalid network file", nnue_path, "with magic", magic);
-                    throw std::invalid_argument("Invalid network file with magic " + std::to_string(magic));
+        unsigned int get_feature(Color perspective, Piece piece, unsigned int sq) const {
+            return get_feature_index<FEATURE_SET>(perspective, piece, sq, king_squares[perspective]);
+        }
+
+        template<bool ADD>
+        void update(Piece piece, unsigned int sq) {
+            if (!dirty[WHITE] && !dirty[BLACK]) {
+                const unsigned int white_feature = get_feature(WHITE, piece, sq), black_feature = get_feature(BLACK, piece, sq);
+                if constexpr (ADD) {
+                    accumulator.add_feature(white_feature, black_feature);
+                } else {
+                    accumulator.remove_feature(white_feature, black_feature);
                 }
+                return;
+            }
 
-                accumulator.load_from_file(file);
-                l1.load_from_file(file);
+            for (Color perspective : {WHITE, BLACK}) {
+                if (dirty[perspective]) continue;
+                if constexpr (ADD) {
+                    accumulator.add_feature(perspective, get_feature(perspective, piece, sq));
+                } else {
+                    accumulator.remove_feature(perspective, get_feature(perspective, piece, sq));
+                }
+            }
+        }
 
-                file.close();
+        void refresh(Color perspective) {
+            CacheEntry &entry = cache[perspective][get_king_index(perspective, king_squares[perspective])];
+            const auto &weights = params->accumulator.weights;
 
-                logger.print("Loaded network file", nnue_path);
+            for (unsigned int index = 0; index < 12; index++) {
+                const Piece piece(index_to_type[index % 6], index_to_color[index / 6]);
+                chess::Bitboard added = pieces[index] & ~entry.pieces[index];
+                chess::Bitboard removed = entry.pieces[index] & ~pieces[index];
+                while (added) {
+                    simd::add_epi16<L1_SIZE>(entry.accumulator.data(), &weights[get_feature(perspective, piece, added.pop_lsb()) * L1_SIZE]);
+                }
+                while (removed) {
+                    simd::sub_epi16<L1_SIZE>(entry.accumulator.data(), &weights[get_feature(perspective, piece, removed.pop_lsb()) * L1_SIZE]);
+                }
+                entry.pieces[index] = pieces[index];
             }
-        }*/
+
+            accumulator.load(perspective, entry.accumulator);
+            dirty[perspective] = false;
+        }
+    };
+
+    class NNUE {
+
+    public:
+        static constexpr int QSCALE = PackedNetwork::QSCALE;
+
+        explicit NNUE(const NetworkRef &network = get_default_network()) : evaluator(make_evaluator(network)) {}
+
+        // Switches to another network, the accumulator has to be refreshed afterwards.
+        void set_network(const NetworkRef &network) {
+            evaluator = make_evaluator(network);
+        }
 
         void refresh(const std::vector<unsigned int> &features) {
-            accumulator.refresh(features);
+            std::visit([&](auto &e) { e.refresh(features); }, evaluator);
         }
 
         void activate(Piece piece, unsigned int sq) {
             assert(piece.is_ok());
-            accumulator.add_feature(get_feature_index(piece, sq));
+            std::visit([&](auto &e) { e.activate(piece, sq); }, evaluator);
         }
 
         void deactivate(Piece piece, unsigned int sq) {
             assert(piece.is_ok());
-            accumulator.remove_feature(get_feature_index(piece, sq));
+            std::visit([&](auto &e) { e.deactivate(piece, sq); }, evaluator);
         }
 
         Score evaluate(Color stm) {
-            accumulator.push(l0_output);
-            l1.forward(stm, l0_output, l1_output);
-            int32_t score = l1_output[0];
-            if (stm == BLACK) score *= -1;
-            return (score * 400) / (QSCALE * QSCALE);
+            return std::visit([&](auto &e) { return e.evaluate(stm); }, evaluator);
         }
 
         static constexpr unsigned int get_feature_index(Piece piece, unsigned int sq) {
-            return (piece.color == WHITE) * 384 + piece.type * 64 + sq;
+            return nn::get_feature_index<FeatureSet::PIECE_SQUARE>(WHITE, piece, sq, 0);
         }
 
     private:
-        static constexpr int MAGIC = -6;
-        static constexpr size_t L1_SIZE = 512;
+        template<typename NETWORK>
+        using EvaluatorFor = std::conditional_t<NETWORK::FEATURE_SET == FeatureSet::KING_BUCKETS, KingBucketEvaluator<NETWORK>, Evaluator<NETWORK>>;
 
-        alignas(64) std::array<int16_t, L1_SIZE> l0_output;
-        alignas(64) std::array<int32_t, 1> l1_output;
+        template<typename>
+        struct EvaluatorVariant;
 
-        layers::Accumulator<768, L1_SIZE, int16_t, activations::crelu<int16_t, QSCALE>> accumulator;
-        layers::DenseLayerBucket<2, L1_SIZE, 1, int16_t, int32_t, activations::none<int16_t>> l1;
+        template<typename... NETWORKS>
+        struct EvaluatorVariant<std::variant<const NETWORKS *...>> {
+            using type = std::variant<EvaluatorFor<NETWORKS>...>;
+        };
+
+        using Evaluators = EvaluatorVariant<NetworkRef>::type;
+
+        Evaluators evaluator;
+
+        static Evaluators make_evaluator(const NetworkRef &network) {
+            return std::visit([](auto *params) -> Evaluators { return EvaluatorFor<std::decay_t<decltype(*params)>>(*params); }, network);
+        }
     };
 
 } // namespace nn
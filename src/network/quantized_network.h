@@ -0,0 +1,183 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../utils/utilities.h"
+#include "activations/none.h"
+#include "features.h"
+#include "layers/accumulator.h"
+#include "layers/dense_layer_bucket.h"
+#include "layers/int8_dense_layer.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+namespace nn {
+
+    // Network files start with a header describing the architecture, followed by the in-memory image
+    // of the matching QuantizedNetwork, so that a memory mapped file can be used without copying.
+    struct NetworkHeader {
+        static constexpr uint32_t MAGIC = 0x4E4E4357; // "WCNN"
+        static constexpr uint32_t FORMAT_VERSION = 3;
+
+        uint32_t magic = MAGIC;
+        uint32_t version = FORMAT_VERSION;
+        uint64_t payload_size = 0;
+        FeatureSet feature_set = FeatureSet::PIECE_SQUARE;
+        uint32_t input_size = 0;
+        uint32_t hidden_size = 0;
+        uint32_t perspectives = 0;
+        uint32_t output_buckets = 0;
+        int32_t accumulator_scale = 0;
+        int32_t output_scale = 0;
+        // The sizes of the int8 hidden layers, or 0 without them. These used to be reserved bytes, which were always 0.
+        uint32_t l2_size = 0;
+        uint32_t l3_size = 0;
+        std::array<char, 12> reserved{};
+
+        [[nodiscard]] std::string describe() const {
+            const std::string output = l2_size == 0 ? "1" : "(" + std::to_string(l2_size) + "->" + std::to_string(l3_size) + "->1)";
+            return "feature set " + std::to_string(static_cast<uint32_t>(feature_set)) + ", " + std::to_string(input_size) + "->" +
+                   std::to_string(hidden_size) + "x" + std::to_string(perspectives) + "->" + std::to_string(output_buckets) + "x" + output + ", scales " +
+                   std::to_string(accumulator_scale) + "/" + std::to_string(output_scale);
+        }
+    };
+
+    static_assert(sizeof(NetworkHeader) == 64);
+
+    // The quantized parameters of the network. They are loaded once and only read afterwards,
+    // so a single copy is shared by every search thread.
+    //
+    // With one perspective the hidden layer is computed from white's point of view, and the output is white relative.
+    // With two perspectives the hidden layer is computed for both sides using the same weights,
+    // the output layer takes the side to move first, and its output is relative to the side to move.
+    // King bucketed features depend on the own king, so they are only supported with two perspectives.
+    //
+    // When L2 is not 0, the output layer is replaced by int8 hidden layers L1->L2->L3->1, which take the activated
+    // accumulators as uint8. They are also only supported with two perspectives.
+    template<size_t L1, size_t P = 1, FeatureSet FS = FeatureSet::PIECE_SQUARE, size_t L2 = 0, size_t L3 = 0>
+    struct QuantizedNetwork {
+        static_assert(P == 1 || P == 2);
+        static_assert(FS == FeatureSet::PIECE_SQUARE || P == 2);
+        static_assert(L2 == 0 || (P == 2 && L3 != 0));
+
+        static constexpr FeatureSet FEATURE_SET = FS;
+        static constexpr size_t INPUT_SIZE = input_size(FEATURE_SET);
+        static constexpr size_t L1_SIZE = L1;
+        static constexpr size_t PERSPECTIVES = P;
+        static constexpr size_t OUTPUT_BUCKETS = 2;
+        static constexpr size_t L2_SIZE = L2;
+        static constexpr size_t L3_SIZE = L3;
+        static constexpr bool HIDDEN_LAYERS = L2_SIZE != 0;
+        static constexpr int QSCALE = 64;
+
+        // The type of the activated accumulator
+        using L1Input = std::conditional_t<HIDDEN_LAYERS, uint8_t, int16_t>;
+
+        layers::AccumulatorWeights<INPUT_SIZE, L1_SIZE, int16_t> accumulator;
+        std::conditional_t<HIDDEN_LAYERS,
+                           layers::Int8HiddenLayers<OUTPUT_BUCKETS, L1_SIZE * PERSPECTIVES, L2_SIZE, L3_SIZE, QSCALE>,
+                           layers::DenseLayerBucket<OUTPUT_BUCKETS, L1_SIZE * PERSPECTIVES, 1, int16_t, int32_t, activations::none<int16_t>>>
+                l1;
+
+        static constexpr int PACKED_MAGIC = (FEATURE_SET == FeatureSet::KING_BUCKETS ? -8 : PERSPECTIVES == 2 ? -7 : -6) - (HIDDEN_LAYERS ? 3 : 0);
+        static constexpr size_t PACKED_SIZE =
+                sizeof(int) + sizeof(int16_t) * (L1_SIZE + INPUT_SIZE * L1_SIZE) +
+                (HIDDEN_LAYERS ? OUTPUT_BUCKETS * (sizeof(int32_t) * (L2_SIZE + L3_SIZE + 1) + L1_SIZE * PERSPECTIVES * L2_SIZE + L2_SIZE * L3_SIZE + L3_SIZE)
+                               : sizeof(int16_t) * OUTPUT_BUCKETS * (1 + L1_SIZE * PERSPECTIVES));
+
+        static NetworkHeader get_header() {
+            NetworkHeader header;
+            header.payload_size = sizeof(QuantizedNetwork);
+            header.feature_set = FEATURE_SET;
+            header.input_size = INPUT_SIZE;
+            header.hidden_size = L1_SIZE;
+            header.perspectives = PERSPECTIVES;
+            header.output_buckets = OUTPUT_BUCKETS;
+            header.accumulator_scale = QSCALE;
+            header.output_scale = QSCALE;
+            header.l2_size = L2_SIZE;
+            header.l3_size = L3_SIZE;
+            return header;
+        }
+
+        static bool describes(const NetworkHeader &header) {
+            const NetworkHeader expected = get_header();
+            return header.payload_size == expected.payload_size && header.feature_set == expected.feature_set &&
+                   header.input_size == expected.input_size && header.hidden_size == expected.hidden_size && header.perspectives == expected.perspectives &&
+                   header.output_buckets == expected.output_buckets && header.accumulator_scale == expected.accumulator_scale &&
+                   header.output_scale == expected.output_scale && header.l2_size == expected.l2_size && header.l3_size == expected.l3_size;
+        }
+
+        // Loads the packed format without header, written by older versions of the quantize command.
+        void load_packed(const unsigned char *data, size_t size) {
+            if (size != PACKED_SIZE) {
+                throw std::invalid_argument("Invalid network size " + std::to_string(size) + ", expected " + std::to_string(PACKED_SIZE));
+            }
+
+            int magic;
+            std::memcpy(&magic, data, sizeof(int));
+            int offset = sizeof(int);
+
+            if (magic != PACKED_MAGIC) {
+                throw std::invalid_argument("Invalid network file with magic " + std::to_string(magic));
+            }
+
+            offset = accumulator.load_from_pointer(data, offset);
+            offset = l1.load_from_pointer(data, offset);
+
+            assert(size_t(offset) == size);
+        }
+    };
+
+    // The architectures that can be loaded at runtime, each one is compiled with constant sized loops.
+    template<typename... NETWORKS>
+    struct ArchitectureList {
+        static_assert((std::is_trivially_copyable_v<NETWORKS> && ...));
+        static_assert((std::is_standard_layout_v<NETWORKS> && ...));
+
+        using NetworkRef = std::variant<const NETWORKS *...>;
+
+        // Interprets payload as the network described by header.
+        static std::optional<NetworkRef> from_payload(const NetworkHeader &header, const unsigned char *payload) {
+            std::optional<NetworkRef> result;
+            ((NETWORKS::describes(header) && (result = reinterpret_cast<const NETWORKS *>(payload), true)) || ...);
+            return result;
+        }
+    };
+
+    using Architectures = ArchitectureList<QuantizedNetwork<256>, QuantizedNetwork<512>, QuantizedNetwork<768>, QuantizedNetwork<1024>,
+                                           QuantizedNetwork<256, 2>, QuantizedNetwork<512, 2>, QuantizedNetwork<768, 2>, QuantizedNetwork<1024, 2>,
+                                           QuantizedNetwork<256, 2, FeatureSet::KING_BUCKETS>, QuantizedNetwork<512, 2, FeatureSet::KING_BUCKETS>,
+                                           QuantizedNetwork<768, 2, FeatureSet::KING_BUCKETS>, QuantizedNetwork<1024, 2, FeatureSet::KING_BUCKETS>,
+                                           QuantizedNetwork<512, 2, FeatureSet::PIECE_SQUARE, 16, 32>, QuantizedNetwork<1024, 2, FeatureSet::PIECE_SQUARE, 16, 32>,
+                                           QuantizedNetwork<512, 2, FeatureSet::KING_BUCKETS, 16, 32>, QuantizedNetwork<1024, 2, FeatureSet::KING_BUCKETS, 16, 32>>;
+
+    // Points to the read-only parameters of one of the supported architectures.
+    using NetworkRef = Architectures::NetworkRef;
+
+    // Networks without header use the architecture of the first released networks.
+    using PackedNetwork = QuantizedNetwork<512>;
+
+} // namespace nn
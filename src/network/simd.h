@@ -0,0 +1,810 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/constants.h"
+#include "../utils/cpu.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include <type_traits>
+
+namespace nn::simd {
+
+    // The positions of the set bits of every 8-bit mask, used to turn a mask of non-zero input groups into their indices.
+    inline constexpr auto NNZ_LOOKUP = [] {
+        std::array<std::array<uint16_t, 8>, 256> table{};
+        for (size_t mask = 0; mask < 256; mask++) {
+            size_t count = 0;
+            for (uint16_t bit = 0; bit < 8; bit++) {
+                if (mask & (1 << bit)) table[mask][count++] = bit;
+            }
+        }
+        return table;
+    }();
+
+    // Reference implementation of the kernels used by the quantized network.
+    // Every SIMD implementation must produce bit-identical results.
+    struct Scalar {
+        static constexpr const char *NAME = "scalar";
+        static constexpr size_t WIDTH = 1;
+
+        template<size_t N>
+        static void add_epi16(int16_t *acc, const int16_t *weights) {
+            for (size_t i = 0; i < N; i++) {
+                acc[i] += weights[i];
+            }
+        }
+
+        template<size_t N>
+        static void sub_epi16(int16_t *acc, const int16_t *weights) {
+            for (size_t i = 0; i < N; i++) {
+                acc[i] -= weights[i];
+            }
+        }
+
+        // Updates the accumulators of both perspectives in a single pass.
+        template<size_t N>
+        static void add2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+            for (size_t i = 0; i < N; i++) {
+                acc0[i] += weights0[i];
+                acc1[i] += weights1[i];
+            }
+        }
+
+        template<size_t N>
+        static void sub2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+            for (size_t i = 0; i < N; i++) {
+                acc0[i] -= weights0[i];
+                acc1[i] -= weights1[i];
+            }
+        }
+
+        // Sets acc to biases plus the rows of weights selected by features, every row holds N elements.
+        template<size_t N>
+        static void accumulate_epi16(int16_t *acc, const int16_t *biases, const int16_t *weights, const unsigned int *features, size_t count) {
+            for (size_t i = 0; i < N; i++) {
+                acc[i] = biases[i];
+            }
+            for (size_t k = 0; k < count; k++) {
+                add_epi16<N>(acc, &weights[features[k] * N]);
+            }
+        }
+
+        template<size_t N, typename ACTIVATION>
+        static void activate_epi16(const int16_t *input, int16_t *output) {
+            for (size_t i = 0; i < N; i++) {
+                output[i] = ACTIVATION::forward(input[i]);
+            }
+        }
+
+        template<size_t N>
+        static int32_t dot_epi16(const int16_t *a, const int16_t *b) {
+            int32_t sum = 0;
+            for (size_t i = 0; i < N; i++) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        // Activates the accumulator into the uint8 input of the int8 hidden layers, ACTIVATION has to clamp into [0, 127].
+        template<size_t N, typename ACTIVATION>
+        static void activate_epu8(const int16_t *input, uint8_t *output) {
+            for (size_t i = 0; i < N; i++) {
+                output[i] = ACTIVATION::forward(input[i]);
+            }
+        }
+
+        // The inputs are at most 127, so the pairwise int16 sums of the SIMD implementations can't saturate.
+        template<size_t N>
+        static int32_t dot_epu8_epi8(const uint8_t *a, const int8_t *b) {
+            int32_t sum = 0;
+            for (size_t i = 0; i < N; i++) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        // Computes the OUT outputs of a dense layer with uint8 inputs, whose int8 weights are ordered by groups of 4 inputs:
+        // the 4 weights of the first output for the first group, then of the second output, and so on.
+        // This way every output is updated with a single multiply-add of the 4 inputs broadcast into each 32-bit element.
+        template<size_t IN, size_t OUT>
+        static void affine_epu8_epi8(const uint8_t *input, const int8_t *weights, const int32_t *biases, int32_t *output) {
+            for (size_t j = 0; j < OUT; j++) {
+                output[j] = biases[j];
+            }
+            for (size_t i = 0; i < IN; i++) {
+                for (size_t j = 0; j < OUT; j++) {
+                    output[j] += input[i] * weights[(i / 4) * OUT * 4 + j * 4 + i % 4];
+                }
+            }
+        }
+
+        // Writes the indices of the groups of 4 inputs containing a non-zero input, and returns their count.
+        // The SIMD implementations store several indices at a time, so indices needs room for all N / 4 groups.
+        template<size_t N>
+        static size_t find_nnz(const uint8_t *input, uint16_t *indices) {
+            size_t count = 0;
+            for (size_t i = 0; i < N / 4; i++) {
+                uint32_t group;
+                std::memcpy(&group, &input[i * 4], sizeof(group));
+                if (group != 0) indices[count++] = i;
+            }
+            return count;
+        }
+
+        // Same as affine_epu8_epi8, but only the count groups of 4 inputs listed in nnz are read, every other input has to be zero.
+        template<size_t IN, size_t OUT>
+        static void affine_sparse_epu8_epi8(const uint8_t *input, const uint16_t *nnz, size_t count, const int8_t *weights, const int32_t *biases,
+                                            int32_t *output) {
+            for (size_t j = 0; j < OUT; j++) {
+                output[j] = biases[j];
+            }
+            for (size_t k = 0; k < count; k++) {
+                const size_t group = nnz[k];
+                for (size_t i = group * 4; i < group * 4 + 4; i++) {
+                    for (size_t j = 0; j < OUT; j++) {
+                        output[j] += input[i] * weights[(i / 4) * OUT * 4 + j * 4 + i % 4];
+                    }
+                }
+            }
+        }
+    };
+
+#ifdef KERNELS_AVX2
+    struct Avx2 {
+        static constexpr const char *NAME = "avx2";
+        static constexpr size_t WIDTH = 256 / 16;
+
+        template<size_t N>
+        TARGET_AVX2 static void add_epi16(int16_t *acc, const int16_t *weights) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m256i base = _mm256_load_si256((__m256i *) &acc[i]);
+                __m256i weight = _mm256_load_si256((const __m256i *) &weights[i]);
+                _mm256_store_si256((__m256i *) &acc[i], _mm256_add_epi16(base, weight));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX2 static void sub_epi16(int16_t *acc, const int16_t *weights) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m256i base = _mm256_load_si256((__m256i *) &acc[i]);
+                __m256i weight = _mm256_load_si256((const __m256i *) &weights[i]);
+                _mm256_store_si256((__m256i *) &acc[i], _mm256_sub_epi16(base, weight));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX2 static void add2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m256i base0 = _mm256_load_si256((__m256i *) &acc0[i]);
+                __m256i base1 = _mm256_load_si256((__m256i *) &acc1[i]);
+                __m256i weight0 = _mm256_load_si256((const __m256i *) &weights0[i]);
+                __m256i weight1 = _mm256_load_si256((const __m256i *) &weights1[i]);
+                _mm256_store_si256((__m256i *) &acc0[i], _mm256_add_epi16(base0, weight0));
+                _mm256_store_si256((__m256i *) &acc1[i], _mm256_add_epi16(base1, weight1));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX2 static void sub2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m256i base0 = _mm256_load_si256((__m256i *) &acc0[i]);
+                __m256i base1 = _mm256_load_si256((__m256i *) &acc1[i]);
+                __m256i weight0 = _mm256_load_si256((const __m256i *) &weights0[i]);
+                __m256i weight1 = _mm256_load_si256((const __m256i *) &weights1[i]);
+                _mm256_store_si256((__m256i *) &acc0[i], _mm256_sub_epi16(base0, weight0));
+                _mm256_store_si256((__m256i *) &acc1[i], _mm256_sub_epi16(base1, weight1));
+            }
+        }
+
+        // The accumulator is built in blocks that fit into registers, so it is only stored once per block.
+        template<size_t N>
+        TARGET_AVX2 static void accumulate_epi16(int16_t *acc, const int16_t *biases, const int16_t *weights, const unsigned int *features, size_t count) {
+            constexpr size_t REGISTERS = 8;
+            static_assert(N % (REGISTERS * WIDTH) == 0);
+            for (size_t block = 0; block < N; block += REGISTERS * WIDTH) {
+                __m256i sums[REGISTERS];
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    sums[r] = _mm256_load_si256((const __m256i *) &biases[block + r * WIDTH]);
+                }
+                for (size_t k = 0; k < count; k++) {
+                    const int16_t *row = &weights[features[k] * N + block];
+                    for (size_t r = 0; r < REGISTERS; r++) {
+                        sums[r] = _mm256_add_epi16(sums[r], _mm256_load_si256((const __m256i *) &row[r * WIDTH]));
+                    }
+                }
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    _mm256_store_si256((__m256i *) &acc[block + r * WIDTH], sums[r]);
+                }
+            }
+        }
+
+        template<size_t N, typename ACTIVATION>
+        TARGET_AVX2 static void activate_epi16(const int16_t *input, int16_t *output) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+            static_assert(std::is_invocable_r_v<__m256i, decltype(ACTIVATION::_mm256_forward_epi16), __m256i>, "ACTIVATION::forward doesn't support AVX2 registers");
+#pragma GCC diagnostic pop
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m256i base = _mm256_load_si256((const __m256i *) &input[i]);
+                _mm256_store_si256((__m256i *) &output[i], ACTIVATION::_mm256_forward_epi16(base));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX2 static int32_t dot_epi16(const int16_t *a, const int16_t *b) {
+            static_assert(N % WIDTH == 0);
+            __m256i sum = _mm256_setzero_si256();
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m256i va = _mm256_load_si256((const __m256i *) &a[i]);
+                __m256i vb = _mm256_load_si256((const __m256i *) &b[i]);
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(va, vb));
+            }
+            return reduce_add_epi32(sum);
+        }
+
+        template<size_t N, typename ACTIVATION>
+        TARGET_AVX2 static void activate_epu8(const int16_t *input, uint8_t *output) {
+            static_assert(N % (2 * WIDTH) == 0);
+            for (size_t i = 0; i < N; i += 2 * WIDTH) {
+                __m256i lo = ACTIVATION::_mm256_forward_epi16(_mm256_load_si256((const __m256i *) &input[i]));
+                __m256i hi = ACTIVATION::_mm256_forward_epi16(_mm256_load_si256((const __m256i *) &input[i + WIDTH]));
+                // packus interleaves the 128-bit lanes of its operands
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+                _mm256_store_si256((__m256i *) &output[i], packed);
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX2 static int32_t dot_epu8_epi8(const uint8_t *a, const int8_t *b) {
+            static_assert(N % 32 == 0);
+            const __m256i ones = _mm256_set1_epi16(1);
+            __m256i sum = _mm256_setzero_si256();
+            for (size_t i = 0; i < N; i += 32) {
+                __m256i va = _mm256_loadu_si256((const __m256i *) &a[i]);
+                __m256i vb = _mm256_loadu_si256((const __m256i *) &b[i]);
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(va, vb), ones));
+            }
+            return reduce_add_epi32(sum);
+        }
+
+        template<size_t IN, size_t OUT>
+        TARGET_AVX2 static void affine_epu8_epi8(const uint8_t *input, const int8_t *weights, const int32_t *biases, int32_t *output) {
+            static_assert(IN % 4 == 0 && OUT % 8 == 0);
+            constexpr size_t REGISTERS = OUT / 8;
+            const __m256i ones = _mm256_set1_epi16(1);
+
+            __m256i sums[REGISTERS];
+            for (size_t r = 0; r < REGISTERS; r++) {
+                sums[r] = _mm256_loadu_si256((const __m256i *) &biases[r * 8]);
+            }
+            for (size_t i = 0; i < IN; i += 4) {
+                int32_t group;
+                std::memcpy(&group, &input[i], sizeof(group));
+                const __m256i inputs = _mm256_set1_epi32(group);
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    __m256i weight = _mm256_loadu_si256((const __m256i *) &weights[i * OUT + r * 32]);
+                    sums[r] = _mm256_add_epi32(sums[r], _mm256_madd_epi16(_mm256_maddubs_epi16(inputs, weight), ones));
+                }
+            }
+            for (size_t r = 0; r < REGISTERS; r++) {
+                _mm256_storeu_si256((__m256i *) &output[r * 8], sums[r]);
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX2 static size_t find_nnz(const uint8_t *input, uint16_t *indices) {
+            static_assert(N % 32 == 0);
+            const __m128i increment = _mm_set1_epi16(8);
+            __m128i base = _mm_setzero_si128();
+            size_t count = 0;
+            for (size_t i = 0; i < N; i += 32) {
+                __m256i zero = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i *) &input[i]), _mm256_setzero_si256());
+                const uint32_t mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(zero)) & 0xFF;
+                __m128i offsets = _mm_loadu_si128((const __m128i *) NNZ_LOOKUP[mask].data());
+                _mm_storeu_si128((__m128i *) &indices[count], _mm_add_epi16(base, offsets));
+                count += std::popcount(mask);
+                base = _mm_add_epi16(base, increment);
+            }
+            return count;
+        }
+
+        template<size_t IN, size_t OUT>
+        TARGET_AVX2 static void affine_sparse_epu8_epi8(const uint8_t *input, const uint16_t *nnz, size_t count, const int8_t *weights,
+                                                        const int32_t *biases, int32_t *output) {
+            static_assert(IN % 4 == 0 && OUT % 8 == 0);
+            constexpr size_t REGISTERS = OUT / 8;
+            const __m256i ones = _mm256_set1_epi16(1);
+
+            __m256i sums[REGISTERS];
+            for (size_t r = 0; r < REGISTERS; r++) {
+                sums[r] = _mm256_loadu_si256((const __m256i *) &biases[r * 8]);
+            }
+            for (size_t k = 0; k < count; k++) {
+                const size_t i = size_t(nnz[k]) * 4;
+                int32_t group;
+                std::memcpy(&group, &input[i], sizeof(group));
+                const __m256i inputs = _mm256_set1_epi32(group);
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    __m256i weight = _mm256_loadu_si256((const __m256i *) &weights[i * OUT + r * 32]);
+                    sums[r] = _mm256_add_epi32(sums[r], _mm256_madd_epi16(_mm256_maddubs_epi16(inputs, weight), ones));
+                }
+            }
+            for (size_t r = 0; r < REGISTERS; r++) {
+                _mm256_storeu_si256((__m256i *) &output[r * 8], sums[r]);
+            }
+        }
+
+        TARGET_AVX2 static int32_t reduce_add_epi32(__m256i sum) {
+            __m128i result = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            result = _mm_add_epi32(result, _mm_shuffle_epi32(result, 0x4E));
+            result = _mm_add_epi32(result, _mm_shuffle_epi32(result, 0xB1));
+            return _mm_cvtsi128_si32(result);
+        }
+    };
+#endif
+
+#ifdef KERNELS_AVX512
+    struct Avx512 {
+        static constexpr const char *NAME = "avx512";
+        static constexpr size_t WIDTH = 512 / 16;
+
+        template<size_t N>
+        TARGET_AVX512 static void add_epi16(int16_t *acc, const int16_t *weights) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m512i base = _mm512_load_si512((__m512i *) &acc[i]);
+                __m512i weight = _mm512_load_si512((const __m512i *) &weights[i]);
+                _mm512_store_si512((__m512i *) &acc[i], _mm512_add_epi16(base, weight));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX512 static void sub_epi16(int16_t *acc, const int16_t *weights) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m512i base = _mm512_load_si512((__m512i *) &acc[i]);
+                __m512i weight = _mm512_load_si512((const __m512i *) &weights[i]);
+                _mm512_store_si512((__m512i *) &acc[i], _mm512_sub_epi16(base, weight));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX512 static void add2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m512i base0 = _mm512_load_si512((__m512i *) &acc0[i]);
+                __m512i base1 = _mm512_load_si512((__m512i *) &acc1[i]);
+                __m512i weight0 = _mm512_load_si512((const __m512i *) &weights0[i]);
+                __m512i weight1 = _mm512_load_si512((const __m512i *) &weights1[i]);
+                _mm512_store_si512((__m512i *) &acc0[i], _mm512_add_epi16(base0, weight0));
+                _mm512_store_si512((__m512i *) &acc1[i], _mm512_add_epi16(base1, weight1));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX512 static void sub2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m512i base0 = _mm512_load_si512((__m512i *) &acc0[i]);
+                __m512i base1 = _mm512_load_si512((__m512i *) &acc1[i]);
+                __m512i weight0 = _mm512_load_si512((const __m512i *) &weights0[i]);
+                __m512i weight1 = _mm512_load_si512((const __m512i *) &weights1[i]);
+                _mm512_store_si512((__m512i *) &acc0[i], _mm512_sub_epi16(base0, weight0));
+                _mm512_store_si512((__m512i *) &acc1[i], _mm512_sub_epi16(base1, weight1));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX512 static void accumulate_epi16(int16_t *acc, const int16_t *biases, const int16_t *weights, const unsigned int *features, size_t count) {
+            constexpr size_t REGISTERS = 8;
+            static_assert(N % (REGISTERS * WIDTH) == 0);
+            for (size_t block = 0; block < N; block += REGISTERS * WIDTH) {
+                __m512i sums[REGISTERS];
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    sums[r] = _mm512_load_si512((const __m512i *) &biases[block + r * WIDTH]);
+                }
+                for (size_t k = 0; k < count; k++) {
+                    const int16_t *row = &weights[features[k] * N + block];
+                    for (size_t r = 0; r < REGISTERS; r++) {
+                        sums[r] = _mm512_add_epi16(sums[r], _mm512_load_si512((const __m512i *) &row[r * WIDTH]));
+                    }
+                }
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    _mm512_store_si512((__m512i *) &acc[block + r * WIDTH], sums[r]);
+                }
+            }
+        }
+
+        template<size_t N, typename ACTIVATION>
+        TARGET_AVX512 static void activate_epi16(const int16_t *input, int16_t *output) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+            static_assert(std::is_invocable_r_v<__m512i, decltype(ACTIVATION::_mm512_forward_epi16), __m512i>, "ACTIVATION::forward doesn't support AVX-512 registers");
+#pragma GCC diagnostic pop
+            static_assert(N % WIDTH == 0);
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m512i base = _mm512_load_si512((const __m512i *) &input[i]);
+                _mm512_store_si512((__m512i *) &output[i], ACTIVATION::_mm512_forward_epi16(base));
+            }
+        }
+
+        template<size_t N>
+        TARGET_AVX512 static int32_t dot_epi16(const int16_t *a, const int16_t *b) {
+            static_assert(N % WIDTH == 0);
+            __m512i sum = _mm512_setzero_si512();
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m512i va = _mm512_load_si512((const __m512i *) &a[i]);
+                __m512i vb = _mm512_load_si512((const __m512i *) &b[i]);
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(va, vb));
+            }
+            return _mm512_reduce_add_epi32(sum);
+        }
+
+        template<size_t N, typename ACTIVATION>
+        TARGET_AVX512 static void activate_epu8(const int16_t *input, uint8_t *output) {
+            static_assert(N % (2 * WIDTH) == 0);
+            const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+            for (size_t i = 0; i < N; i += 2 * WIDTH) {
+                __m512i lo = ACTIVATION::_mm512_forward_epi16(_mm512_load_si512((const __m512i *) &input[i]));
+                __m512i hi = ACTIVATION::_mm512_forward_epi16(_mm512_load_si512((const __m512i *) &input[i + WIDTH]));
+                // packus interleaves the 128-bit lanes of its operands
+                __m512i packed = _mm512_permutexvar_epi64(order, _mm512_packus_epi16(lo, hi));
+                _mm512_store_si512((__m512i *) &output[i], packed);
+            }
+        }
+
+        // Layers whose size isn't a multiple of 64 finish with a 256-bit step.
+        template<size_t N>
+        TARGET_AVX512 static int32_t dot_epu8_epi8(const uint8_t *a, const int8_t *b) {
+            static_assert(N % 32 == 0);
+            __m512i sum = _mm512_setzero_si512();
+            for (size_t i = 0; i + 64 <= N; i += 64) {
+                __m512i va = _mm512_loadu_si512((const __m512i *) &a[i]);
+                __m512i vb = _mm512_loadu_si512((const __m512i *) &b[i]);
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(_mm512_maddubs_epi16(va, vb), _mm512_set1_epi16(1)));
+            }
+            return _mm512_reduce_add_epi32(sum) + dot_epu8_epi8_tail<N>(a, b);
+        }
+
+        template<size_t IN, size_t OUT>
+        TARGET_AVX512 static void affine_epu8_epi8(const uint8_t *input, const int8_t *weights, const int32_t *biases, int32_t *output) {
+            static_assert(IN % 4 == 0 && OUT % 16 == 0);
+            constexpr size_t REGISTERS = OUT / 16;
+            const __m512i ones = _mm512_set1_epi16(1);
+
+            __m512i sums[REGISTERS];
+            for (size_t r = 0; r < REGISTERS; r++) {
+                sums[r] = _mm512_loadu_si512((const __m512i *) &biases[r * 16]);
+            }
+            for (size_t i = 0; i < IN; i += 4) {
+                int32_t group;
+                std::memcpy(&group, &input[i], sizeof(group));
+                const __m512i inputs = _mm512_set1_epi32(group);
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    __m512i weight = _mm512_loadu_si512((const __m512i *) &weights[i * OUT + r * 64]);
+                    sums[r] = _mm512_add_epi32(sums[r], _mm512_madd_epi16(_mm512_maddubs_epi16(inputs, weight), ones));
+                }
+            }
+            for (size_t r = 0; r < REGISTERS; r++) {
+                _mm512_storeu_si512((__m512i *) &output[r * 16], sums[r]);
+            }
+        }
+
+        // The indices of 16 groups are compressed at once, so the lookup table is not needed.
+        template<size_t N>
+        TARGET_AVX512 static size_t find_nnz(const uint8_t *input, uint16_t *indices) {
+            static_assert(N % 64 == 0);
+            const __m512i increment = _mm512_set1_epi32(16);
+            __m512i base = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            size_t count = 0;
+            for (size_t i = 0; i < N; i += 64) {
+                __m512i groups = _mm512_load_si512((const __m512i *) &input[i]);
+                const __mmask16 mask = _mm512_test_epi32_mask(groups, groups);
+                __m256i packed = _mm512_cvtepi32_epi16(_mm512_maskz_compress_epi32(mask, base));
+                _mm256_storeu_si256((__m256i *) &indices[count], packed);
+                count += std::popcount(uint32_t(mask));
+                base = _mm512_add_epi32(base, increment);
+            }
+            return count;
+        }
+
+        template<size_t IN, size_t OUT>
+        TARGET_AVX512 static void affine_sparse_epu8_epi8(const uint8_t *input, const uint16_t *nnz, size_t count, const int8_t *weights,
+                                                          const int32_t *biases, int32_t *output) {
+            static_assert(IN % 4 == 0 && OUT % 16 == 0);
+            constexpr size_t REGISTERS = OUT / 16;
+            const __m512i ones = _mm512_set1_epi16(1);
+
+            __m512i sums[REGISTERS];
+            for (size_t r = 0; r < REGISTERS; r++) {
+                sums[r] = _mm512_loadu_si512((const __m512i *) &biases[r * 16]);
+            }
+            for (size_t k = 0; k < count; k++) {
+                const size_t i = size_t(nnz[k]) * 4;
+                int32_t group;
+                std::memcpy(&group, &input[i], sizeof(group));
+                const __m512i inputs = _mm512_set1_epi32(group);
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    __m512i weight = _mm512_loadu_si512((const __m512i *) &weights[i * OUT + r * 64]);
+                    sums[r] = _mm512_add_epi32(sums[r], _mm512_madd_epi16(_mm512_maddubs_epi16(inputs, weight), ones));
+                }
+            }
+            for (size_t r = 0; r < REGISTERS; r++) {
+                _mm512_storeu_si512((__m512i *) &output[r * 16], sums[r]);
+            }
+        }
+
+    protected:
+        template<size_t N>
+        TARGET_AVX512 static int32_t dot_epu8_epi8_tail(const uint8_t *a, const int8_t *b) {
+            if constexpr (N % 64 == 0) {
+                return 0;
+            } else {
+                __m256i va = _mm256_loadu_si256((const __m256i *) &a[N - 32]);
+                __m256i vb = _mm256_loadu_si256((const __m256i *) &b[N - 32]);
+                __m256i sum = _mm256_madd_epi16(_mm256_maddubs_epi16(va, vb), _mm256_set1_epi16(1));
+                __m128i result = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+                result = _mm_add_epi32(result, _mm_shuffle_epi32(result, 0x4E));
+                result = _mm_add_epi32(result, _mm_shuffle_epi32(result, 0xB1));
+                return _mm_cvtsi128_si32(result);
+            }
+        }
+    };
+#endif
+
+#ifdef KERNELS_VNNI512
+    // Same as Avx512, but the multiply-adds of the dot products are fused into a single vpdpwssd or vpdpbusd.
+    struct Vnni512 : Avx512 {
+        static constexpr const char *NAME = "avx512-vnni";
+
+        template<size_t N>
+        TARGET_VNNI512 static int32_t dot_epi16(const int16_t *a, const int16_t *b) {
+            static_assert(N % WIDTH == 0);
+            __m512i sum = _mm512_setzero_si512();
+            for (size_t i = 0; i < N; i += WIDTH) {
+                __m512i va = _mm512_load_si512((const __m512i *) &a[i]);
+                __m512i vb = _mm512_load_si512((const __m512i *) &b[i]);
+                sum = _mm512_dpwssd_epi32(sum, va, vb);
+            }
+            return _mm512_reduce_add_epi32(sum);
+        }
+
+        template<size_t N>
+        TARGET_VNNI512 static int32_t dot_epu8_epi8(const uint8_t *a, const int8_t *b) {
+            static_assert(N % 32 == 0);
+            __m512i sum = _mm512_setzero_si512();
+            for (size_t i = 0; i + 64 <= N; i += 64) {
+                __m512i va = _mm512_loadu_si512((const __m512i *) &a[i]);
+                __m512i vb = _mm512_loadu_si512((const __m512i *) &b[i]);
+                sum = _mm512_dpbusd_epi32(sum, va, vb);
+            }
+            return _mm512_reduce_add_epi32(sum) + dot_epu8_epi8_tail<N>(a, b);
+        }
+
+        // vpdpbusd has a latency of several cycles, so consecutive groups are accumulated into independent registers.
+        template<size_t IN, size_t OUT>
+        TARGET_VNNI512 static void affine_epu8_epi8(const uint8_t *input, const int8_t *weights, const int32_t *biases, int32_t *output) {
+            static_assert(IN % 4 == 0 && OUT % 16 == 0);
+            constexpr size_t REGISTERS = OUT / 16;
+            constexpr size_t CHAINS = IN % 16 == 0 ? 4 : 1;
+
+            __m512i sums[CHAINS][REGISTERS];
+            for (size_t c = 0; c < CHAINS; c++) {
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    sums[c][r] = c == 0 ? _mm512_loadu_si512((const __m512i *) &biases[r * 16]) : _mm512_setzero_si512();
+                }
+            }
+            for (size_t i = 0; i < IN; i += 4 * CHAINS) {
+                for (size_t c = 0; c < CHAINS; c++) {
+                    int32_t group;
+                    std::memcpy(&group, &input[i + 4 * c], sizeof(group));
+                    const __m512i inputs = _mm512_set1_epi32(group);
+                    for (size_t r = 0; r < REGISTERS; r++) {
+                        __m512i weight = _mm512_loadu_si512((const __m512i *) &weights[(i + 4 * c) * OUT + r * 64]);
+                        sums[c][r] = _mm512_dpbusd_epi32(sums[c][r], inputs, weight);
+                    }
+                }
+            }
+            for (size_t r = 0; r < REGISTERS; r++) {
+                for (size_t c = 1; c < CHAINS; c++) {
+                    sums[0][r] = _mm512_add_epi32(sums[0][r], sums[c][r]);
+                }
+                _mm512_storeu_si512((__m512i *) &output[r * 16], sums[0][r]);
+            }
+        }
+
+        template<size_t IN, size_t OUT>
+        TARGET_VNNI512 static void affine_sparse_epu8_epi8(const uint8_t *input, const uint16_t *nnz, size_t count, const int8_t *weights,
+                                                           const int32_t *biases, int32_t *output) {
+            static_assert(IN % 4 == 0 && OUT % 16 == 0);
+            constexpr size_t REGISTERS = OUT / 16;
+            constexpr size_t CHAINS = 4;
+
+            __m512i sums[CHAINS][REGISTERS];
+            for (size_t c = 0; c < CHAINS; c++) {
+                for (size_t r = 0; r < REGISTERS; r++) {
+                    sums[c][r] = c == 0 ? _mm512_loadu_si512((const __m512i *) &biases[r * 16]) : _mm512_setzero_si512();
+                }
+            }
+            size_t k = 0;
+            for (; k + CHAINS <= count; k += CHAINS) {
+                for (size_t c = 0; c < CHAINS; c++) {
+                    accumulate_group<OUT>(sums[c], input, weights, nnz[k + c]);
+                }
+            }
+            for (; k < count; k++) {
+                accumulate_group<OUT>(sums[0], input, weights, nnz[k]);
+            }
+            for (size_t r = 0; r < REGISTERS; r++) {
+                for (size_t c = 1; c < CHAINS; c++) {
+                    sums[0][r] = _mm512_add_epi32(sums[0][r], sums[c][r]);
+                }
+                _mm512_storeu_si512((__m512i *) &output[r * 16], sums[0][r]);
+            }
+        }
+
+    private:
+        template<size_t OUT>
+        TARGET_VNNI512 static void accumulate_group(__m512i *sums, const uint8_t *input, const int8_t *weights, size_t group) {
+            int32_t inputs;
+            std::memcpy(&inputs, &input[group * 4], sizeof(inputs));
+            const __m512i broadcast = _mm512_set1_epi32(inputs);
+            for (size_t r = 0; r < OUT / 16; r++) {
+                __m512i weight = _mm512_loadu_si512((const __m512i *) &weights[group * 4 * OUT + r * 64]);
+                sums[r] = _mm512_dpbusd_epi32(sums[r], broadcast, weight);
+            }
+        }
+    };
+#endif
+
+    enum class Isa {
+        scalar,
+        avx2,
+        avx512,
+        vnni512
+    };
+
+    // The kernels used by the network, selected once at startup in dispatch builds,
+    // otherwise the widest instruction set enabled at compile time.
+#if defined(DISPATCH)
+    Isa active = Isa::scalar;
+#elif defined(VNNI512)
+    constexpr Isa active = Isa::vnni512;
+#elif defined(AVX512)
+    constexpr Isa active = Isa::avx512;
+#elif defined(AVX2)
+    constexpr Isa active = Isa::avx2;
+#else
+    constexpr Isa active = Isa::scalar;
+#endif
+
+    // All kernels operate on whole registers of the widest instruction set.
+    constexpr size_t MAX_WIDTH = 512 / 16;
+
+    void select(const cpu::Features &features) {
+#ifdef DISPATCH
+        if (features.vnni512) {
+            active = Isa::vnni512;
+        } else if (features.avx512) {
+            active = Isa::avx512;
+        } else if (features.avx2) {
+            active = Isa::avx2;
+        } else {
+            active = Isa::scalar;
+        }
+#endif
+    }
+
+    // Calls func with the kernels of the active instruction set.
+    template<typename FUNC>
+    inline decltype(auto) dispatch(FUNC &&func) {
+        switch (active) {
+#ifdef KERNELS_VNNI512
+            case Isa::vnni512:
+                return func(Vnni512());
+#endif
+#ifdef KERNELS_AVX512
+            case Isa::avx512:
+                return func(Avx512());
+#endif
+#ifdef KERNELS_AVX2
+            case Isa::avx2:
+                return func(Avx2());
+#endif
+            default:
+                return func(Scalar());
+        }
+    }
+
+    [[nodiscard]] const char *get_name() {
+        return dispatch([](auto kernels) { return decltype(kernels)::NAME; });
+    }
+
+    template<size_t N>
+    inline void add_epi16(int16_t *acc, const int16_t *weights) {
+        dispatch([&](auto kernels) { decltype(kernels)::template add_epi16<N>(acc, weights); });
+    }
+
+    template<size_t N>
+    inline void sub_epi16(int16_t *acc, const int16_t *weights) {
+        dispatch([&](auto kernels) { decltype(kernels)::template sub_epi16<N>(acc, weights); });
+    }
+
+    template<size_t N>
+    inline void add2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+        dispatch([&](auto kernels) { decltype(kernels)::template add2_epi16<N>(acc0, weights0, acc1, weights1); });
+    }
+
+    template<size_t N>
+    inline void sub2_epi16(int16_t *acc0, const int16_t *weights0, int16_t *acc1, const int16_t *weights1) {
+        dispatch([&](auto kernels) { decltype(kernels)::template sub2_epi16<N>(acc0, weights0, acc1, weights1); });
+    }
+
+    template<size_t N>
+    inline void accumulate_epi16(int16_t *acc, const int16_t *biases, const int16_t *weights, const unsigned int *features, size_t count) {
+        dispatch([&](auto kernels) { decltype(kernels)::template accumulate_epi16<N>(acc, biases, weights, features, count); });
+    }
+
+    template<size_t N, typename ACTIVATION>
+    inline void activate_epi16(const int16_t *input, int16_t *output) {
+        dispatch([&](auto kernels) { decltype(kernels)::template activate_epi16<N, ACTIVATION>(input, output); });
+    }
+
+    template<size_t N>
+    inline int32_t dot_epi16(const int16_t *a, const int16_t *b) {
+        return dispatch([&](auto kernels) { return decltype(kernels)::template dot_epi16<N>(a, b); });
+    }
+
+    template<size_t N, typename ACTIVATION>
+    inline void activate_epu8(const int16_t *input, uint8_t *output) {
+        dispatch([&](auto kernels) { decltype(kernels)::template activate_epu8<N, ACTIVATION>(input, output); });
+    }
+
+    template<size_t N>
+    inline int32_t dot_epu8_epi8(const uint8_t *a, const int8_t *b) {
+        return dispatch([&](auto kernels) { return decltype(kernels)::template dot_epu8_epi8<N>(a, b); });
+    }
+
+    template<size_t IN, size_t OUT>
+    inline void affine_epu8_epi8(const uint8_t *input, const int8_t *weights, const int32_t *biases, int32_t *output) {
+        dispatch([&](auto kernels) { decltype(kernels)::template affine_epu8_epi8<IN, OUT>(input, weights, biases, output); });
+    }
+
+    template<size_t N>
+    inline size_t find_nnz(const uint8_t *input, uint16_t *indices) {
+        return dispatch([&](auto kernels) { return decltype(kernels)::template find_nnz<N>(input, indices); });
+    }
+
+    template<size_t IN, size_t OUT>
+    inline void affine_sparse_epu8_epi8(const uint8_t *input, const uint16_t *nnz, size_t count, const int8_t *weights, const int32_t *biases,
+                                        int32_t *output) {
+        dispatch([&](auto kernels) { decltype(kernels)::template affine_sparse_epu8_epi8<IN, OUT>(input, nnz, count, weights, biases, output); });
+    }
+
+} // namespace nn::simd
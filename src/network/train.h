@@ -43,13 +43,11 @@ namespace nn {
             std::ofstream log_file("log.txt", std::ios::out);
 
             if (network_path) {
-                network = Network(network_path.value());
-            } else {
-                network = Network();
+                network.load(network_path.value());
             }
 
-            entries = new std::string[batch_size];
-            entries_next = new std::string[batch_size];
+            entries = new chess::PackedBoard[batch_size];
+            entries_next = new chess::PackedBoard[batch_size];
 
             bool _;
             training_parser.read_batch(batch_size, entries_next, _);
@@ -74,9 +72,9 @@ namespace nn {
 
                     delete[] entries;
                     entries = entries_next;
-                    entries_next = new std::string[batch_size];
+                    entries_next = new chess::PackedBoard[batch_size];
 
-                    gradients.assign(thread_count, Gradient());
+                    gradients = std::vector<Gradient>(thread_count);
                     errors.assign(thread_count, 0.0f);
                     accuracy.assign(thread_count, 0);
 
@@ -155,12 +153,12 @@ namespace nn {
         std::vector<Gradient> gradients;
         std::vector<float> errors;
         std::vector<int> accuracy;
-        std::string *entries, *entries_next;
+        chess::PackedBoard *entries, *entries_next;
 
         std::pair<float, float> test_validation() {
             bool _;
             delete[] entries;
-            entries = new std::string[batch_size];
+            entries = new chess::PackedBoard[batch_size];
             validation_parser.read_batch(batch_size, entries, _);
 
             errors.assign(thread_count, 0.0f);
@@ -195,19 +193,24 @@ namespace nn {
             for (size_t i = id; i < batch_size; i += thread_count) {
                 TrainingEntry entry(entries[i]);
 
-                process_entry<train>(id, entry.white_features, entry.wdl, entry.eval, entry.stm);
-                process_entry<train>(id, entry.black_features, 1.0f - entry.wdl, 1.0f - entry.eval, color_enemy(entry.stm));
+                process_entry<train>(id, entry.white_features, entry.black_features, entry.wdl, entry.eval, entry.stm);
+                process_entry<train>(id, entry.black_features, entry.white_features, 1.0f - entry.wdl, 1.0f - entry.eval, color_enemy(entry.stm));
             }
         }
 
         template<bool train>
-        void process_entry(int id, const std::vector<unsigned int> &features, float wdl, float eval, Color stm) {
-            std::array<float, L1_SIZE> l0_output;
-            std::array<float, L1_SIZE> l0_loss;
-            std::array<float, 1> l1_output;
+        void process_entry(int id, const std::vector<unsigned int> &white_features, const std::vector<unsigned int> &black_features, float wdl, float eval, Color stm) {
+            if constexpr (PERSPECTIVES == 2) {
+                // The output of dual perspective networks is relative to the side to move
+                if (stm == BLACK) {
+                    wdl = 1.0f - wdl;
+                    eval = 1.0f - eval;
+                }
+            }
 
-            network.forward(features, l0_output, l1_output, stm);
-            float prediction = l1_output[0];
+            LayerOutputs outputs;
+            network.forward(white_features, black_features, outputs, stm);
+            float prediction = outputs.prediction();
 
             float error = (1.0f - eval_influence) * (prediction - wdl) * (prediction - wdl) +
                           eval_influence * (prediction - eval) * (prediction - eval);
@@ -224,22 +227,16 @@ namespace nn {
             errors[id] += error;
 
             if constexpr (train) {
-                std::array<float, 1> l1_loss = {(1 - eval_influence) * 2.0f * (prediction - wdl) + eval_influence * 2.0f * (prediction - eval)};
+                float loss = (1 - eval_influence) * 2.0f * (prediction - wdl) + eval_influence * 2.0f * (prediction - eval);
 
-                network.l1.backward(stm, l1_loss, l0_output, l1_output, l0_loss, gradients[id].l1);
-                network.l0.backward(l0_loss, features, l0_output, gradients[id].l0);
+                network.backward(white_features, black_features, outputs, loss, stm, gradients[id]);
             }
         }
 
         void index_training_data(const std::string &training_data) {
             print("Indexing training data...");
 
-            std::string tmp;
-            std::ifstream file(training_data, std::ios::in);
-            while (std::getline(file, tmp)) {
-                entry_count++;
-            }
-            file.close();
+            entry_count = DataParser::count_entries(training_data);
 
             print("Found", entry_count, "positions");
         }
@@ -0,0 +1,73 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/board.h"
+
+#include <algorithm>
+
+namespace search {
+
+    // Learns how much the static evaluation misses the search results in positions with the same pawn structure,
+    // or with the same pieces of one side. Every table keeps a running average of the differences in CORRECTION_GRAIN units.
+    class CorrectionHistory {
+
+    public:
+        static constexpr unsigned int CORRECTION_SIZE = 16384;
+        static constexpr Score CORRECTION_GRAIN = 256;
+        static constexpr Score CORRECTION_MAX = 64 * CORRECTION_GRAIN;
+
+        [[nodiscard]] Score correct(const chess::Board &board, Score eval) const {
+            const Color stm = board.get_stm();
+            const Score correction = 2 * pawn[stm][index(board.get_pawn_hash())] +
+                                     non_pawn[stm][WHITE][index(board.get_non_pawn_hash(WHITE))] +
+                                     non_pawn[stm][BLACK][index(board.get_non_pawn_hash(BLACK))];
+            return std::clamp(eval + correction / (4 * CORRECTION_GRAIN), -WORST_MATE + 1, WORST_MATE - 1);
+        }
+
+        // Moves the entries towards the difference of the search score and the uncorrected evaluation,
+        // faster when the search was deeper.
+        void update(const chess::Board &board, Score eval, Score score, Depth depth) {
+            const Color stm = board.get_stm();
+            const Score diff = std::clamp(score - eval, -CORRECTION_MAX / CORRECTION_GRAIN, CORRECTION_MAX / CORRECTION_GRAIN);
+            const Score weight = std::min(1 + int(depth), 16);
+
+            update_entry(pawn[stm][index(board.get_pawn_hash())], diff, weight);
+            update_entry(non_pawn[stm][WHITE][index(board.get_non_pawn_hash(WHITE))], diff, weight);
+            update_entry(non_pawn[stm][BLACK][index(board.get_non_pawn_hash(BLACK))], diff, weight);
+        }
+
+        void clear() {
+            std::fill(&pawn[0][0], &pawn[0][0] + 2 * CORRECTION_SIZE, 0);
+            std::fill(&non_pawn[0][0][0], &non_pawn[0][0][0] + 4 * CORRECTION_SIZE, 0);
+        }
+
+    private:
+        Score pawn[2][CORRECTION_SIZE];
+        Score non_pawn[2][2][CORRECTION_SIZE];
+
+        static unsigned int index(chess::Zobrist hash) {
+            return hash % CORRECTION_SIZE;
+        }
+
+        static void update_entry(Score &entry, Score diff, Score weight) {
+            entry = (entry * (256 - weight) + diff * CORRECTION_GRAIN * weight) / 256;
+        }
+    };
+
+} // namespace search
@@ -17,8 +17,11 @@
 
 #pragma once
 
+#include "../chess/board.h"
 #include "../chess/move.h"
 
+#include <algorithm>
+
 namespace search {
 
     struct SearchStack {
@@ -26,6 +29,8 @@ namespace search {
         chess::Move move;
         PieceType pt;
         Score eval;
+        // The move skipped by the singular extension search of the node
+        chess::Move excluded_move;
     };
 
     class History {
@@ -35,6 +40,7 @@ namespace search {
         chess::Move counter_moves[64][64];
         Score butterfly[64][64];
         Score conthist[6][64][64][64];
+        Score capthist[2][6][64][6];
 
         /**
          * Adds a beta-cutoff to the History.
@@ -76,6 +82,22 @@ namespace search {
             }
         }
 
+        /**
+         * Adds a beta-cutoff of a capture, or decreases the history of a capture that did not cause one.
+         *
+         * @param board The board before the capture
+         * @param move The capture
+         * @param bonus The change of the history, positive for a cutoff
+         */
+        void update_capture_history(const chess::Board &board, chess::Move move, Score bonus) {
+            update_history(get_capthist_ref(board, move), bonus);
+        }
+
+        Score get_capture_history(const chess::Board &board, chess::Move move) const {
+            const Piece piece = board.piece_at(move.get_from());
+            return capthist[piece.color][piece.type][move.get_to()][get_captured(board, move)];
+        }
+
         Score get_history(chess::Move move, SearchStack *ss) const {
             Score value = butterfly[move.get_from()][move.get_to()];
 
@@ -94,6 +116,7 @@ namespace search {
          * Clears the history.
          */
         void clear() {
+            std::fill(&capthist[0][0][0][0], &capthist[0][0][0][0] + sizeof(capthist) / sizeof(Score), 0);
             for (int i = 0; i < MAX_PLY + 2; i++) {
                 killer_moves[i][0] = killer_moves[i][1] = chess::NULL_MOVE;
             }
@@ -131,6 +154,16 @@ namespace search {
             return conthist[(ss - ply)->pt][(ss - ply)->move.get_to()][move.get_from()][move.get_to()];
         }
 
+        // Captures are told apart by the moving piece, the target square and the captured piece
+        static PieceType get_captured(const chess::Board &board, chess::Move move) {
+            return move.eq_flag(chess::Move::EP_CAPTURE) ? PAWN : board.piece_at(move.get_to()).type;
+        }
+
+        Score &get_capthist_ref(const chess::Board &board, chess::Move move) {
+            const Piece piece = board.piece_at(move.get_from());
+            return capthist[piece.color][piece.type][move.get_to()][get_captured(board, move)];
+        }
+
         static void update_history(Score &entry, Score bonus) {
             int scaled = bonus - entry * std::abs(bonus) / 32768;
             entry += scaled;
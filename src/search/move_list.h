@@ -22,7 +22,7 @@
 #include "see.h"
 
 namespace search {
-    template<bool captures_only>
+    template<Color stm, bool captures_only>
     class MoveList {
 
         static constexpr int MOVE_SCORE_HASH = 10'000'000;
@@ -34,9 +34,18 @@ namespace search {
         static constexpr int MOVE_SCORE_COUNTER = 5'000'000;
         static constexpr int MOVE_SCORE_BAD_CAPTURE = 4'000'000;
 
+        // Captures whose history is at least this high are ordered as good captures without the static exchange evaluation
+        static constexpr Score CAPTURE_HISTORY_TRUSTED = 8192;
+
+        enum SeeResult : uint8_t {
+            SEE_UNKNOWN,
+            SEE_PASSED,
+            SEE_FAILED
+        };
+
     public:
         /**
-         * The MoveList class provides an ordered list of legal moves.
+         * The MoveList class provides an ordered list of legal moves for stm, who must be the side to move.
          *
          * @param board The current board
          * @param hash_move Previously found best move
@@ -46,10 +55,11 @@ namespace search {
          */
         MoveList(const chess::Board &board, const chess::Move &hash_move, const History &history, SearchStack *ss) : current(0), board(board), ss(ss),
                                                                                                                      hash_move(hash_move), last_move((ss - 1)->move), history(history), ply(ss->ply) {
-            size = chess::gen_moves(board, moves, captures_only) - moves;
-            std::transform(moves, moves + size, scores, [this](const chess::Move &move) {
-                return score_move(move);
-            });
+            size = chess::gen_moves<stm, captures_only>(board, moves) - moves;
+            for (unsigned int i = 0; i < size; i++) {
+                see_results[i] = SEE_UNKNOWN;
+                scores[i] = score_move(moves[i], see_results[i]);
+            }
         }
 
         /**
@@ -70,15 +80,30 @@ namespace search {
                 if (scores[i] > scores[current]) {
                     std::swap(scores[i], scores[current]);
                     std::swap(moves[i], moves[current]);
+                    std::swap(see_results[i], see_results[current]);
                 }
             }
             return moves[current++];
         }
 
+        /**
+         * The static exchange evaluation is reused if the ordering already needed it, otherwise it is done now.
+         *
+         * @return True if the move returned last by next_move does not lose material
+         */
+        [[nodiscard]] bool is_see_passed() {
+            SeeResult &result = see_results[current - 1];
+            if (result == SEE_UNKNOWN) {
+                result = see(board, moves[current - 1], 0) ? SEE_PASSED : SEE_FAILED;
+            }
+            return result == SEE_PASSED;
+        }
+
     private:
         chess::Move moves[200];
         unsigned int size, current;
         int scores[200];
+        SeeResult see_results[200];
         const chess::Board &board;
         SearchStack *ss;
         const chess::Move &hash_move;
@@ -92,13 +117,19 @@ namespace search {
                            : MVVLVA[board.piece_at(move.get_to()).type][board.piece_at(move.get_from()).type];
         }
 
-        [[nodiscard]] int score_move(const chess::Move &move) const {
+        [[nodiscard]] int score_move(const chess::Move &move, SeeResult &see_result) const {
             if (move == hash_move) {
                 return MOVE_SCORE_HASH;
             } else if (move.is_promo()) {
                 return move.get_promo_type() == QUEEN ? MOVE_SCORE_GOOD_PROMO : MOVE_SCORE_BAD_PROMO;
             } else if (move.is_capture()) {
-                return (see(board, move, 0) ? MOVE_SCORE_GOOD_CAPTURE : MOVE_SCORE_BAD_CAPTURE) + get_mvv_lva(move);
+                // The history breaks the ties between the attackers, and between the victims only if it is strong
+                const Score capture_history = history.get_capture_history(board, move);
+                if (capture_history < CAPTURE_HISTORY_TRUSTED) {
+                    see_result = see(board, move, 0) ? SEE_PASSED : SEE_FAILED;
+                }
+                const bool good_capture = see_result != SEE_FAILED;
+                return (good_capture ? MOVE_SCORE_GOOD_CAPTURE : MOVE_SCORE_BAD_CAPTURE) + get_mvv_lva(move) * 2048 + capture_history / 2;
             } else if (move == history.killer_moves[ply][0]) {
                 return MOVE_SCORE_FIRST_KILLER;
             } else if (move == history.killer_moves[ply][1]) {
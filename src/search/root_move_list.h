@@ -0,0 +1,108 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include "../chess/move.h"
+#include "move_list.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace search {
+
+    struct RootMove {
+        chess::Move move;
+        // The score of the last search of the move, or -INF_SCORE if it failed low
+        Score score = -INF_SCORE;
+        // The nodes spent on the move during the whole search, and during the last search of the root
+        int64_t nodes = 0;
+        int64_t last_nodes = 0;
+    };
+
+    // The legal moves of the root, kept between the iterations of a search. Every search of the root tries the previous
+    // best move first, followed by the other moves in the order of the nodes the previous search spent on them.
+    class RootMoveList {
+
+    public:
+        /**
+         * Generates the root moves in the order of a MoveList, which is only used until the first iteration finishes.
+         *
+         * @param board The root position, stm must be the side to move
+         * @param hash_move Best move of the position in the transposition table
+         * @param history History object used for the initial ordering
+         * @param ss Search stack entry of the root
+         */
+        template<Color stm>
+        void init(const chess::Board &board, const chess::Move &hash_move, const History &history, SearchStack *ss) {
+            MoveList<stm, false> move_list(board, hash_move, history, ss);
+            size = 0;
+            while (!move_list.empty()) {
+                moves[size++] = RootMove{move_list.next_move()};
+            }
+            current = size;
+        }
+
+        /**
+         * Orders the moves for a new search of the root. The best move has the highest score, as only the first move and
+         * the moves that raised alpha are scored. A move that needed many nodes to be refuted is likely to be the next best.
+         */
+        void rewind() {
+            current = 0;
+            if (size == 0) return;
+
+            RootMove *best = std::max_element(moves, moves + size, [](const RootMove &a, const RootMove &b) {
+                return a.score < b.score;
+            });
+            std::rotate(moves, best, best + 1);
+            std::stable_sort(moves + 1, moves + size, [](const RootMove &a, const RootMove &b) {
+                return a.last_nodes > b.last_nodes;
+            });
+
+            for (unsigned int i = 0; i < size; i++) {
+                moves[i].score = -INF_SCORE;
+                moves[i].last_nodes = 0;
+            }
+        }
+
+        [[nodiscard]] bool empty() const {
+            return current == size;
+        }
+
+        [[nodiscard]] chess::Move next_move() {
+            return moves[current++].move;
+        }
+
+        /**
+         * @return The root move returned last by next_move
+         */
+        [[nodiscard]] RootMove &last() {
+            return moves[current - 1];
+        }
+
+        [[nodiscard]] int64_t get_nodes(chess::Move move) const {
+            const RootMove *root_move = std::find_if(moves, moves + size, [move](const RootMove &rm) { return rm.move == move; });
+            return root_move != moves + size ? root_move->nodes : 0;
+        }
+
+    private:
+        RootMove moves[200];
+        unsigned int size = 0, current = 0;
+    };
+
+} // namespace search
@@ -49,6 +49,26 @@ namespace search {
             shared.tt.resize(hash_size);
         }
 
+        /**
+         * Sets the network used by the following searches. The running search is stopped,
+         * the network must stay alive until it is replaced.
+         *
+         * @param network Quantized network
+         */
+        void set_network(const nn::NetworkRef &network) {
+            join<false>();
+            shared.network = network;
+        }
+
+        /**
+         * Returns the network used for searching.
+         *
+         * @return Quantized network
+         */
+        const nn::NetworkRef &get_network() const {
+            return shared.network;
+        }
+
         /**
          * Sets the resource limits of the search.
          *
@@ -17,33 +17,67 @@
 
 #include "../chess/board.h"
 #include "../network/eval.h"
+#include "correction_history.h"
 #include "history.h"
 #include "move_list.h"
 #include "pv_array.h"
+#include "root_move_list.h"
 #include "terminal_report.h"
 #include "time_manager.h"
 #include "transposition_table.h"
 
 #include <atomic>
 #include <thread>
+#include <type_traits>
 
 namespace search {
 
-    extern Depth lmr_reductions[200][MAX_PLY + 1];
+    // The natural logarithm of a positive integer, since std::log can't be used in constant expressions.
+    // It is within an ulp of std::log for the values in the reduction table.
+    [[nodiscard]] constexpr double log_constexpr(int value) {
+        double x = value;
+        int exponent = 0;
+        while (x >= 2.0) {
+            x /= 2.0;
+            exponent++;
+        }
+
+        // log(x) = 2 * atanh((x - 1) / (x + 1)), where the series converges quickly for x in [1, 2)
+        const double z = (x - 1.0) / (x + 1.0), z2 = z * z;
+        double power = z, sum = 0.0;
+        for (int k = 1; k < 64; k += 2) {
+            sum += power / k;
+            power *= z2;
+        }
+        return 2.0 * sum + exponent * 0.693147180559945309417;
+    }
+
+    struct LmrTable {
+        Depth reductions[200][MAX_PLY + 1];
+    };
+
+    [[nodiscard]] constexpr LmrTable generate_lmr() {
+        double logs[200] = {};
+        for (int i = 1; i < 200; i++) {
+            logs[i] = log_constexpr(i);
+        }
 
-    void init_lmr() {
+        LmrTable table{};
         for (int made_moves = 0; made_moves < 200; made_moves++) {
             for (Depth depth = 0; depth < MAX_PLY + 1; depth++) {
-                double moves_log = made_moves == 0 ? 0 : std::log(made_moves);
-                double depth_log = depth == 0 ? 0 : std::log(depth);
-                lmr_reductions[made_moves][depth] = 1.0 + moves_log * depth_log / 2.0;
+                table.reductions[made_moves][depth] = 1.0 + logs[made_moves] * logs[depth] / 2.0;
             }
         }
+        return table;
     }
 
+    constexpr LmrTable LMR_TABLE = generate_lmr();
+    constexpr auto &lmr_reductions = LMR_TABLE.reductions;
+
     struct SharedMemory {
         TimeManager tm;
         TT tt;
+        nn::NetworkRef network = nn::get_default_network();
         bool is_searching;
         bool uci_mode = true;
         chess::Move best_move;
@@ -59,7 +93,7 @@ namespace search {
 
     class SearchThread {
     public:
-        SearchThread(SharedMemory &shared_memory, unsigned int thread_id) : nnue(), shared(shared_memory), id(thread_id) {}
+        SearchThread(SharedMemory &shared_memory, unsigned int thread_id) : nnue(shared_memory.network), shared(shared_memory), id(thread_id) {}
 
         void load_board(const chess::Board &position) {
             board = position;
@@ -81,10 +115,12 @@ namespace search {
         std::thread th;
         unsigned int id;
         Ply max_ply;
+        Depth root_depth;
         PVArray pv;
-        int64_t nodes_searched[64][64];
+        RootMoveList root_moves;
 
         History history;
+        CorrectionHistory correction;
 
         template<bool to_tt>
         static Score convert_tt_score(Score score, Ply ply) {
@@ -109,17 +145,42 @@ namespace search {
 
         void init_search() {
 
+            nnue.set_network(shared.network);
+
             if (id == 0) {
                 shared.best_move = chess::NULL_MOVE;
             }
 
             history.clear();
-            for (auto &i : nodes_searched) {
-                for (int64_t &j : i) {
-                    j = 0;
-                }
-            }
+            correction.clear();
             max_ply = 0;
+
+            if (board.get_stm() == WHITE) {
+                init_root_moves<WHITE>();
+            } else {
+                init_root_moves<BLACK>();
+            }
+        }
+
+        template<Color stm>
+        void init_root_moves() {
+            std::optional<TTEntry> entry = shared.tt.probe(board.get_hash());
+            const chess::Move hash_move = entry ? entry->hash_move : chess::NULL_MOVE;
+
+            SearchStack stack[2] = {};
+            stack[0].move = stack[1].move = chess::NULL_MOVE;
+            root_moves.init<stm>(board, hash_move, history, stack + 1);
+        }
+
+        // The root reuses the moves ordered by the previous searches, the other nodes generate them.
+        template<Color stm, bool root_node>
+        std::conditional_t<root_node, RootMoveList &, MoveList<stm, false>> get_move_list(const chess::Move &hash_move, SearchStack *ss) {
+            if constexpr (root_node) {
+                root_moves.rewind();
+                return root_moves;
+            } else {
+                return MoveList<stm, false>(board, hash_move, history, ss);
+            }
         }
 
         void iterative_deepening() {
@@ -158,7 +219,7 @@ namespace search {
 
             prev_bm = bm;
 
-            const double bm_effort = double(nodes_searched[bm.get_from()][bm.get_to()]) / double(shared.node_count[id]);
+            const double bm_effort = double(root_moves.get_nodes(bm)) / double(shared.node_count[id]);
 
             if (id == 0 && depth >= 7) {
                 bool should_continue = shared.tm.handle_iteration(bm_stability, bm_effort);
@@ -202,11 +263,13 @@ namespace search {
             }
 
             max_ply = 0;
+            root_depth = depth;
 
             SearchStack stack[MAX_PLY + 10];
             SearchStack *ss = stack + 7;
             for (Ply i = -7; i <= MAX_PLY + 2; i++) {
                 (ss + i)->move = chess::NULL_MOVE;
+                (ss + i)->excluded_move = chess::NULL_MOVE;
                 (ss + i)->eval = UNKNOWN_SCORE;
                 (ss + i)->ply = i;
             }
@@ -220,7 +283,8 @@ namespace search {
                 if (beta >= BOUND) beta = INF_SCORE;
 
                 nnue.refresh(board.to_features());
-                Score score = search<ROOT_NODE>(depth, alpha, beta, ss);
+                Score score = board.get_stm() == WHITE ? search<WHITE, ROOT_NODE>(depth, alpha, beta, ss)
+                                                       : search<BLACK, ROOT_NODE>(depth, alpha, beta, ss);
 
                 if (score <= alpha) {
                     beta = (alpha + beta) / 2;
@@ -243,15 +307,18 @@ namespace search {
             }
         }
 
-        template<NodeType node_type>
+        // The side to move is a template parameter, so that move generation and making moves need no color dispatch.
+        template<Color stm, NodeType node_type>
         Score search(Depth depth, Score alpha, Score beta, SearchStack *ss) {
+            constexpr Color xstm = color_enemy<stm>();
             constexpr bool root_node = node_type == ROOT_NODE;
             constexpr bool non_root_node = !root_node;
             constexpr bool pv_node = node_type != NON_PV_NODE;
             constexpr bool non_pv_node = !pv_node;
 
             const Score mate_ply = -MATE_VALUE + ss->ply;
-            const bool in_check = board.is_check();
+            const bool in_check = board.is_check<stm>();
+            const bool excluded = ss->excluded_move.is_ok();
 
             chess::Move best_move = chess::NULL_MOVE;
             Score best_score = -INF_SCORE;
@@ -270,7 +337,7 @@ namespace search {
             }
 
             if (non_root_node) {
-                if (board.is_draw<pv_node>()) {
+                if (board.is_draw<pv_node>() || eval::is_known_draw(board)) {
                     return 0;
                 }
 
@@ -289,7 +356,7 @@ namespace search {
             Score tt_score = entry ? convert_tt_score<false>(entry->eval, ss->ply) : UNKNOWN_SCORE;
             chess::Move hash_move = entry ? entry->hash_move : chess::NULL_MOVE;
 
-            if (entry && non_pv_node && entry->depth >= depth && board.get_move50() < 90 &&
+            if (entry && non_pv_node && !excluded && entry->depth >= depth && board.get_move50() < 90 &&
                 (entry->flag == TT_EXACT || (entry->flag == TT_ALPHA && tt_score <= alpha) || (entry->flag == TT_BETA && tt_score >= beta))) {
                 stat_tracker::record_success("tt_cutoff");
                 return tt_score;
@@ -298,19 +365,20 @@ namespace search {
             }
 
             if (depth <= 0)
-                return qsearch<node_type>(alpha, beta, ss);
+                return qsearch<stm, node_type>(alpha, beta, ss);
 
-            Score static_eval = ss->eval = eval::evaluate(board, nnue);
+            const Score raw_eval = eval::evaluate(board, nnue);
+            Score static_eval = ss->eval = correction.correct(board, raw_eval);
             bool improving = ss->ply >= 2 && ss->eval >= (ss - 2)->eval;
 
-            if (root_node || in_check)
+            if (root_node || in_check || excluded)
                 goto search_moves;
 
             if (!entry && non_pv_node && depth >= 4)
                 depth--;
 
             if (depth <= 3 && static_eval + 150 * depth <= alpha) {
-                Score score = qsearch<NON_PV_NODE>(alpha, beta, ss);
+                Score score = qsearch<stm, NON_PV_NODE>(alpha, beta, ss);
                 if (score <= alpha)
                     return score;
             }
@@ -327,7 +395,7 @@ namespace search {
                 ss->move = chess::NULL_MOVE;
 
                 board.make_null_move();
-                Score score = -search<NON_PV_NODE>(depth - R, -beta, -beta + 1, ss + 1);
+                Score score = -search<xstm, NON_PV_NODE>(depth - R, -beta, -beta + 1, ss + 1);
                 board.undo_null_move();
 
                 if (score >= beta) {
@@ -340,8 +408,44 @@ namespace search {
                 }
             }
 
+            // A capture that wins enough material to beat a raised beta in a reduced search most likely beats beta as well.
+            // The captures are verified by a quiescence search first, and skipped if the hash entry does not expect a cutoff.
+            if (non_pv_node && depth >= 5 && std::abs(beta) < WORST_MATE &&
+                !(entry && entry->depth >= depth - 3 && tt_score < beta + 200)) {
+                const Score probcut_beta = beta + 200;
+                MoveList<stm, true> capture_list(board, hash_move, history, ss);
+
+                while (!capture_list.empty()) {
+                    chess::Move move = ss->move = capture_list.next_move();
+                    ss->pt = board.piece_at(move.get_from()).type;
+
+                    if (!see(board, move, probcut_beta - static_eval)) continue;
+
+                    shared.node_count[id]++;
+                    board.make_move<stm>(move, &nnue);
+
+                    Score score = -qsearch<xstm, NON_PV_NODE>(-probcut_beta, -probcut_beta + 1, ss + 1);
+                    if (score >= probcut_beta) {
+                        score = -search<xstm, NON_PV_NODE>(depth - 4, -probcut_beta, -probcut_beta + 1, ss + 1);
+                    }
+
+                    board.undo_move<stm>(move, &nnue);
+
+                    if (!shared.is_searching) {
+                        return UNKNOWN_SCORE;
+                    }
+
+                    if (score >= probcut_beta) {
+                        stat_tracker::record_success("probcut");
+                        shared.tt.save(board.get_hash(), depth - 3, convert_tt_score<true>(score, ss->ply), TT_BETA, move);
+                        return score;
+                    }
+                }
+                stat_tracker::record_fail("probcut");
+            }
+
         search_moves:
-            MoveList<false> move_list(board, hash_move, history, ss);
+            std::conditional_t<root_node, RootMoveList &, MoveList<stm, false>> move_list = get_move_list<stm, root_node>(hash_move, ss);
 
             if (move_list.empty()) {
                 return in_check ? mate_ply : 0;
@@ -349,8 +453,8 @@ namespace search {
 
             history.killer_moves[ss->ply + 1][0] = history.killer_moves[ss->ply + 1][1] = chess::NULL_MOVE;
 
-            chess::Move quiet_moves[200];
-            chess::Move *next_quiet_move = quiet_moves;
+            chess::Move quiet_moves[200], capture_moves[200];
+            chess::Move *next_quiet_move = quiet_moves, *next_capture_move = capture_moves;
 
             bool skip_quiets = false;
             int made_moves = 0;
@@ -358,6 +462,8 @@ namespace search {
                 chess::Move move = ss->move = move_list.next_move();
                 ss->pt = board.piece_at(move.get_from()).type;
 
+                if (move == ss->excluded_move) continue;
+
                 if (skip_quiets && move.is_quiet() && !move.is_promo()) continue;
 
                 if (non_root_node && non_pv_node && !in_check && std::abs(best_score) < WORST_MATE) {
@@ -387,12 +493,41 @@ namespace search {
                     }
                 }
 
+                // The hash move is singular if all the other moves fail low against a margin below its score in a reduced search,
+                // then it is extended. If even the margin is above beta, more moves beat beta, and the node is cut instead.
+                Depth extension = 0;
+                if (non_root_node && !excluded && move == hash_move && depth >= 8 && ss->ply < 2 * root_depth && entry->flag != TT_ALPHA &&
+                    entry->depth >= depth - 3 && std::abs(tt_score) < WORST_MATE) {
+                    const Score singular_beta = tt_score - 2 * depth;
+
+                    ss->excluded_move = move;
+                    const Score score = search<stm, NON_PV_NODE>((depth - 1) / 2, singular_beta - 1, singular_beta, ss);
+                    ss->excluded_move = chess::NULL_MOVE;
+
+                    // The verification searched the same node, which overwrote the stack entry and the principal variation
+                    ss->move = move;
+                    ss->pt = board.piece_at(move.get_from()).type;
+                    if (id == 0) pv.length[ss->ply] = ss->ply;
+
+                    if (!shared.is_searching) {
+                        return UNKNOWN_SCORE;
+                    }
+
+                    if (score < singular_beta) {
+                        stat_tracker::record_success("singular");
+                        extension = 1;
+                    } else {
+                        stat_tracker::record_fail("singular");
+                        if (singular_beta >= beta) return singular_beta;
+                    }
+                }
+
                 shared.tt.prefetch(board.hash_after_move(move));
-                const Depth new_depth = depth - 1;
+                const Depth new_depth = depth - 1 + extension;
                 const int64_t nodes_before = shared.node_count[id];
 
                 shared.node_count[id]++;
-                board.make_move(move, &nnue);
+                board.make_move<stm>(move, &nnue);
                 Score score;
 
                 if (!in_check && depth >= 3 && made_moves >= 3 + 2 * pv_node && !move.is_promo() && move.is_quiet()) {
@@ -403,32 +538,38 @@ namespace search {
                     R -= std::clamp(history.get_history(move, ss) / 4096, -2, 2);
 
                     Depth D = std::clamp(new_depth - R, 1, depth - 1);
-                    score = -search<NON_PV_NODE>(D, -alpha - 1, -alpha, ss + 1);
+                    score = -search<xstm, NON_PV_NODE>(D, -alpha - 1, -alpha, ss + 1);
 
                     if (score > alpha && R > 1) {
-                        score = -search<NON_PV_NODE>(new_depth, -alpha - 1, -alpha, ss + 1);
+                        score = -search<xstm, NON_PV_NODE>(new_depth, -alpha - 1, -alpha, ss + 1);
                     }
                 } else if (non_pv_node || made_moves != 0) {
-                    score = -search<NON_PV_NODE>(new_depth, -alpha - 1, -alpha, ss + 1);
+                    score = -search<xstm, NON_PV_NODE>(new_depth, -alpha - 1, -alpha, ss + 1);
                 }
 
                 if (pv_node && (made_moves == 0 || (alpha < score && score < beta))) {
-                    score = -search<PV_NODE>(new_depth, -beta, -alpha, ss + 1);
+                    score = -search<xstm, PV_NODE>(new_depth, -beta, -alpha, ss + 1);
                 }
 
-                board.undo_move(move, &nnue);
+                board.undo_move<stm>(move, &nnue);
 
                 const int64_t nodes_after = shared.node_count[id];
                 const int64_t nodes_spent = nodes_after - nodes_before;
 
                 if constexpr (root_node) {
-                    nodes_searched[move.get_from()][move.get_to()] += nodes_spent;
+                    move_list.last().nodes += nodes_spent;
+                    move_list.last().last_nodes = nodes_spent;
                 }
 
                 if (!shared.is_searching) {
                     return UNKNOWN_SCORE;
                 }
 
+                // The moves that fail low are ordered by their nodes
+                if constexpr (root_node) {
+                    if (made_moves == 0 || score > alpha) move_list.last().score = score;
+                }
+
                 if (score >= beta) {
 
                     if (move.is_quiet()) {
@@ -436,6 +577,19 @@ namespace search {
                         for (chess::Move *current_move = quiet_moves; current_move != next_quiet_move; current_move++) {
                             history.decrease_history(*current_move, depth, ss);
                         }
+                    } else {
+                        history.update_capture_history(board, move, depth * 100);
+                    }
+
+                    for (chess::Move *current_move = capture_moves; current_move != next_capture_move; current_move++) {
+                        history.update_capture_history(board, *current_move, -depth * 100);
+                    }
+
+                    // The result without the excluded move is not the value of the node
+                    if (excluded) return beta;
+
+                    if (!in_check && move.is_quiet() && !move.is_promo() && beta > static_eval && std::abs(beta) < WORST_MATE) {
+                        correction.update(board, raw_eval, beta, depth);
                     }
 
                     shared.tt.save(board.get_hash(), depth, convert_tt_score<true>(beta, ss->ply), TT_BETA, move);
@@ -457,7 +611,11 @@ namespace search {
                 }
 
                 made_moves++;
-                if (move.is_quiet()) *next_quiet_move++ = move;
+                if (move.is_quiet()) {
+                    *next_quiet_move++ = move;
+                } else {
+                    *next_capture_move++ = move;
+                }
             }
 
             if (skip_quiets) {
@@ -466,18 +624,31 @@ namespace search {
                 stat_tracker::record_fail("skip_quiets");
             }
 
+            if (excluded) return alpha;
+
+            // Upper bounds only tell that the evaluation was too high
+            if (!in_check && (!best_move.is_ok() || (best_move.is_quiet() && !best_move.is_promo())) &&
+                (flag == TT_EXACT || best_score < static_eval) && std::abs(best_score) < WORST_MATE) {
+                correction.update(board, raw_eval, best_score, depth);
+            }
+
             shared.tt.save(board.get_hash(), depth, convert_tt_score<true>(best_score, ss->ply), flag, best_move);
             return alpha;
         }
 
-        template<NodeType node_type>
+        template<Color stm, NodeType node_type>
         Score qsearch(Score alpha, Score beta, SearchStack *ss) {
+            constexpr Color xstm = color_enemy<stm>();
 
             if (!shared.is_searching) {
                 return UNKNOWN_SCORE;
             }
 
-            Score static_eval = eval::evaluate(board, nnue);
+            if (eval::is_known_draw(board)) {
+                return 0;
+            }
+
+            Score static_eval = correction.correct(board, eval::evaluate(board, nnue));
 
             if (static_eval >= beta) {
                 return beta;
@@ -486,22 +657,22 @@ namespace search {
                 alpha = static_eval;
             }
 
-            MoveList<true> move_list(board, chess::NULL_MOVE, history, ss);
+            MoveList<stm, true> move_list(board, chess::NULL_MOVE, history, ss);
 
             while (!move_list.empty()) {
                 chess::Move move = move_list.next_move();
 
-                if (alpha > -WORST_MATE && !see(board, move, 0)) {
+                if (alpha > -WORST_MATE && !move_list.is_see_passed()) {
                     stat_tracker::record_success("qsearch_see");
-                    break;
+                    continue;
                 } else {
                     stat_tracker::record_fail("qsearch_see");
                 }
 
                 shared.node_count[id]++;
-                board.make_move(move, &nnue);
-                Score score = -qsearch<node_type>(-beta, -alpha, ss + 1);
-                board.undo_move(move, &nnue);
+                board.make_move<stm>(move, &nnue);
+                Score score = -qsearch<xstm, node_type>(-beta, -alpha, ss + 1);
+                board.undo_move<stm>(move, &nnue);
 
                 if (score == UNKNOWN_SCORE) {
                     return UNKNOWN_SCORE;
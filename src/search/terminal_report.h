@@ -15,7 +15,9 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 //
 
+#include <iomanip>
 #include <iostream>
+#include <regex>
 #include <sstream>
 
 #include "../chess/constants.h"
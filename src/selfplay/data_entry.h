@@ -36,21 +36,37 @@ namespace selfplay {
     }
 
     struct DataEntry {
-        std::string fen;
+        chess::PackedBoard board;
         unsigned int ply;
         chess::Move best_move;
         Score eval;
         std::optional<GameResult> result;
 
-        DataEntry(std::string fen, unsigned int ply, chess::Move best_move, Score eval, std::optional<GameResult> result) : fen(std::move(fen)), ply(ply),
-                                                                                                                            best_move(best_move), eval(eval),
-                                                                                                                            result(result) {}
+        DataEntry(const chess::PackedBoard &board, unsigned int ply, chess::Move best_move, Score eval, std::optional<GameResult> result) : board(board), ply(ply),
+                                                                                                                                          best_move(best_move), eval(eval),
+                                                                                                                                          result(result) {}
 
         [[nodiscard]] std::string to_string() const {
-            std::stringstream ss;
-            ss << fen << ";" << ply << ";" << best_move.to_uci() << ";"
-               << int(eval) << ";" << get_wdl(result.value_or(DRAW)) << ";";
-            return ss.str();
+            std::string res = chess::write_fen(chess::unpack(board));
+            res += ';';
+            res += std::to_string(ply);
+            res += ';';
+            res += best_move.to_uci();
+            res += ';';
+            res += std::to_string(int(eval));
+            res += ';';
+            res += get_wdl(result.value_or(DRAW));
+            res += ';';
+            return res;
+        }
+
+        // The best move is not part of the packed format.
+        [[nodiscard]] chess::PackedBoard to_packed() const {
+            chess::PackedBoard packed = board;
+            packed.ply = uint16_t(std::min(ply, 65535u));
+            packed.eval = int16_t(std::clamp<int>(eval, INT16_MIN, INT16_MAX));
+            packed.result = uint8_t(2 - result.value_or(DRAW));
+            return packed;
         }
     };
 
@@ -38,10 +38,13 @@ namespace selfplay {
 
         if (board.is_draw()) return DRAW;
 
-        chess::Move moves[200];
-        int cnt = chess::gen_moves(board, moves, false) - moves;
+        // Known endings are adjudicated
+        const chess::bitbase::ProbeResult probe = chess::bitbase::probe(board);
+        if (probe == chess::bitbase::PROBE_DRAW) return DRAW;
+        if (probe == chess::bitbase::PROBE_WIN) return board.get_stm() == WHITE ? WHITE_WIN : BLACK_WIN;
+        if (probe == chess::bitbase::PROBE_LOSS) return board.get_stm() == WHITE ? BLACK_WIN : WHITE_WIN;
 
-        if (cnt == 0) {
+        if (!chess::has_legal_move(board)) {
             if (board.is_check()) {
                 return board.get_stm() == WHITE ? BLACK_WIN : WHITE_WIN;
             } else {
@@ -64,7 +67,7 @@ namespace selfplay {
             auto [move, eval] = engine.search(board, limits);
 
             if (!board.is_check() && move.is_quiet() && std::abs(eval) < WORST_MATE) {
-                tmp.emplace_back(board.get_fen(), ply, move, eval, std::nullopt);
+                tmp.emplace_back(board.pack(), ply, move, eval, std::nullopt);
                 position_count_vec[thread_id]++;
             }
 
@@ -80,11 +83,27 @@ namespace selfplay {
         }
     }
 
+    void write_entries(std::ofstream &file, const std::vector<DataEntry> &entries, bool packed) {
+        if (packed) {
+            std::vector<chess::PackedBoard> records;
+            records.reserve(entries.size());
+            for (const DataEntry &entry : entries) {
+                records.emplace_back(entry.to_packed());
+            }
+            file.write(reinterpret_cast<const char *>(records.data()), std::streamsize(records.size() * sizeof(chess::PackedBoard)));
+        } else {
+            for (const DataEntry &entry : entries) {
+                file << entry.to_string() << "\n";
+            }
+        }
+    }
+
     void gen_games(const search::Limits &limits, const std::vector<std::string> &starting_fens, const std::string &output_path, size_t thread_id) {
 
         Engine engine;
 
-        std::ofstream file(output_path, std::ios::out | std::ios::app);
+        const bool packed = chess::is_packed_data(output_path);
+        std::ofstream file(output_path, std::ios::out | std::ios::app | (packed ? std::ios::binary : std::ios::openmode()));
         std::random_device rd;
         std::mt19937 g(rd());
 
@@ -96,9 +115,7 @@ namespace selfplay {
             if (entries.size() >= BLOCK_SIZE) {
                 std::shuffle(entries.begin(), entries.end(), g);
 
-                for (const DataEntry &entry : entries) {
-                    file << entry.to_string() << "\n";
-                }
+                write_entries(file, entries, packed);
                 file.flush();
 
                 entries.clear();
@@ -106,9 +123,7 @@ namespace selfplay {
         }
 
         std::shuffle(entries.begin(), entries.end(), g);
-        for (const DataEntry &entry : entries) {
-            file << entry.to_string() << "\n";
-        }
+        write_entries(file, entries, packed);
         file.close();
     }
 
@@ -116,13 +131,11 @@ namespace selfplay {
 
         print("Combining files...");
 
-        std::ofstream file(output_file, std::ios::app | std::ios::out);
+        std::ofstream file(output_file, std::ios::app | std::ios::out | std::ios::binary);
         for (const auto &entry : std::filesystem::directory_iterator(path)) {
-            std::ifstream in(entry.path());
-            std::string tmp;
-            while (std::getline(in, tmp)) {
-                file << tmp << "\n";
-            }
+            std::ifstream in(entry.path(), std::ios::in | std::ios::binary);
+            // Inserting an empty buffer would fail the output stream
+            if (in.peek() != std::ifstream::traits_type::eof()) file << in.rdbuf();
             in.close();
         }
         file.close();
@@ -217,12 +230,13 @@ namespace selfplay {
         std::cout << std::endl;
     }
 
-    void start_generation(const search::Limits &limits, uint64_t games_to_play, size_t thread_count) {
+    void start_generation(const search::Limits &limits, uint64_t games_to_play, size_t thread_count, bool packed) {
 
         game_count_vec.assign(thread_count, 0);
         position_count_vec.assign(thread_count, 0);
 
         const std::string run_id = rng::gen_id();
+        const std::string extension = packed ? std::string(chess::PACKED_DATA_EXTENSION) : ".plain";
         const std::string directory_path = "selfplay/" + run_id;
 
         try_to_create_directory("selfplay");
@@ -239,7 +253,7 @@ namespace selfplay {
             for (size_t i = id; i < starting_fens.size(); i += thread_count) {
                 workload.emplace_back(starting_fens[i]);
             }
-            workers.emplace_back(gen_games, limits, workload, directory_path + "/" + std::to_string(id) + ".plain", id);
+            workers.emplace_back(gen_games, limits, workload, directory_path + "/" + std::to_string(id) + extension, id);
         }
 
         print_progress(games_to_play);
@@ -251,8 +265,8 @@ namespace selfplay {
 
         const std::string output_path = "data/" + get_run_name(limits, run_id);
 
-        combine_data(directory_path, output_path + ".plain");
-        compress_data(output_path + ".plain", output_path + ".zst");
+        combine_data(directory_path, output_path + extension);
+        compress_data(output_path + extension, output_path + ".zst");
 
         exit(0);
     }
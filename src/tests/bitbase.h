@@ -0,0 +1,78 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/bitbase.h"
+
+#include <string>
+#include <vector>
+
+namespace test {
+
+    void test_bitbase() {
+        struct Test {
+            std::string fen;
+            chess::bitbase::ProbeResult result;
+        };
+
+        const std::vector<Test> tests = {
+                {"4k3/8/8/8/8/8/8/4K2R b - - 0 1", chess::bitbase::PROBE_LOSS},
+                {"7k/8/8/8/8/8/8/KQ6 w - - 0 1", chess::bitbase::PROBE_WIN},
+                // Stalemates
+                {"8/8/8/8/8/8/5kr1/7K w - - 0 1", chess::bitbase::PROBE_DRAW},
+                {"7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", chess::bitbase::PROBE_DRAW},
+                // The rook can be captured
+                {"8/8/8/8/8/8/6r1/4k2K w - - 0 1", chess::bitbase::PROBE_DRAW},
+                {"8/8/8/8/8/8/6r1/4k2K b - - 0 1", chess::bitbase::PROBE_WIN},
+                // The king on the sixth rank in front of its pawn wins with either side to move
+                {"4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", chess::bitbase::PROBE_WIN},
+                {"4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", chess::bitbase::PROBE_LOSS},
+                {"8/8/8/8/4p3/4k3/8/4K3 w - - 0 1", chess::bitbase::PROBE_LOSS},
+                {"8/8/8/8/4p3/4k3/8/4K3 b - - 0 1", chess::bitbase::PROBE_WIN},
+                // The defending king blocks the pawn, or the rook pawn from its corner
+                {"8/8/8/8/8/4k3/4P3/4K3 w - - 0 1", chess::bitbase::PROBE_DRAW},
+                {"k7/8/1K6/P7/8/8/8/8 w - - 0 1", chess::bitbase::PROBE_DRAW},
+                // The pawn runs away from the king
+                {"8/8/8/P7/8/8/8/K6k w - - 0 1", chess::bitbase::PROBE_WIN},
+                {"8/8/8/8/8/8/8/KN5k w - - 0 1", chess::bitbase::PROBE_NONE},
+                {"8/8/8/8/8/8/1P6/KN5k w - - 0 1", chess::bitbase::PROBE_NONE}};
+
+        chess::bitbase::wait();
+
+        chess::Board board;
+        std::vector<std::string> failed;
+
+        for (const Test &test : tests) {
+            board.load(test.fen, true);
+            if (chess::bitbase::probe(board) != test.result) {
+                failed.emplace_back(test.fen);
+            }
+        }
+
+        if (failed.empty()) {
+            std::cout << "All bitbase test have passed!" << std::endl;
+        } else {
+            std::cout << failed.size() << " bitbase test have failed:" << std::endl;
+            for (const std::string &fen : failed) {
+                std::cout << fen << std::endl;
+            }
+            std::abort();
+        }
+    }
+
+} // namespace test
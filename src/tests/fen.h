@@ -0,0 +1,89 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/board.h"
+#include "../chess/fen.h"
+#include "../chess/packed_board.h"
+#include "../utils/bench.h"
+
+#include <string>
+#include <vector>
+
+namespace test {
+
+    void test_fen() {
+        std::vector<std::string> failed;
+        chess::Board board;
+
+        // Loading and writing a position gives back the FEN, without the full move counter
+        std::vector<std::string> round_trip = BENCH_FENS;
+        round_trip.emplace_back(STARTING_FEN);
+        round_trip.emplace_back("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        round_trip.emplace_back("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w Kq f6 0 3");
+        for (const std::string &fen : round_trip) {
+            board.load(fen, true);
+            if (board.get_fen() != fen.substr(0, fen.find_last_of(' '))) {
+                failed.emplace_back(fen);
+            }
+
+            // And so does packing it
+            const chess::Zobrist hash = board.get_hash();
+            board.load(board.pack());
+            if (board.get_fen() != fen.substr(0, fen.find_last_of(' ')) || board.get_hash() != hash) {
+                failed.emplace_back("packed " + fen);
+            }
+        }
+
+        const std::vector<std::string> invalid = {
+                "rnbqkbnr/pppppppp/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                "rnbqkbnr/ppppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w KQkq - 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQxq - 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e4 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - x 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR",
+                ""};
+        chess::Fen fen;
+        for (const std::string &str : invalid) {
+            if (chess::parse_fen(str, fen, true)) {
+                failed.emplace_back(str);
+            }
+        }
+
+        // The counters and the castling and en passant fields are optional when not validating
+        if (!chess::parse_fen("8/8/8/4k3/8/8/4K3/8 b", fen, false) || fen.stm != BLACK || fen.rights.data != 0 || fen.ep != NULL_SQUARE || fen.move50 != 0) {
+            failed.emplace_back("8/8/8/4k3/8/8/4K3/8 b");
+        }
+
+        if (failed.empty()) {
+            std::cout << "All fen test have passed!" << std::endl;
+        } else {
+            std::cout << failed.size() << " fen test have failed:" << std::endl;
+            for (const std::string &str : failed) {
+                std::cout << str << std::endl;
+            }
+            std::abort();
+        }
+    }
+
+} // namespace test
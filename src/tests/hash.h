@@ -18,13 +18,39 @@
 #pragma once
 
 #include "../chess/board.h"
+#include "../chess/move_generation.h"
 #include "../uci/uci.h"
 
+#include <string>
 #include <utility>
 #include <vector>
 
 namespace test {
 
+    // Compares the incrementally updated keys to the ones of the loaded position, in every node up to 'depth'.
+    bool incremental_keys_match(chess::Board &board, int depth) {
+        chess::Board loaded;
+        loaded.load(board.get_fen());
+        if (loaded.get_hash() != board.get_hash() || loaded.get_pawn_hash() != board.get_pawn_hash() ||
+            loaded.get_non_pawn_hash(WHITE) != board.get_non_pawn_hash(WHITE) || loaded.get_non_pawn_hash(BLACK) != board.get_non_pawn_hash(BLACK) ||
+            loaded.get_material() != board.get_material()) {
+            std::cout << "Incremental key mismatch in " << board.get_fen() << std::endl;
+            return false;
+        }
+
+        chess::Move moves[200];
+        chess::Move *moves_end = chess::gen_moves(board, moves, false);
+        for (chess::Move *it = moves; depth > 0 && it != moves_end; it++) {
+            board.make_move(*it);
+            const bool matches = incremental_keys_match(board, depth - 1);
+            board.undo_move(*it);
+            if (!matches) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     void test_hash() {
 
         struct Test {
@@ -59,6 +85,18 @@ namespace test {
             }
         }
 
+        // Positions with captures, promotions, en passant and castling
+        const std::vector<std::string> fens = {
+                "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"};
+        for (const std::string &fen : fens) {
+            board.load(fen);
+            if (!incremental_keys_match(board, 2)) {
+                std::abort();
+            }
+        }
+
         if (failed.empty()) {
             std::cout << "All hash test have passed!" << std::endl;
         } else {
@@ -0,0 +1,73 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/material.h"
+#include "../chess/board.h"
+
+#include <string>
+#include <vector>
+
+namespace test {
+
+    void test_material() {
+        chess::Board board;
+
+        struct Test {
+            std::string fen;
+            chess::MaterialKind kind;
+            unsigned int scale;
+        };
+
+        const std::vector<Test> tests = {
+                {STARTING_FEN, chess::MATERIAL_NORMAL, chess::SCALE_NORMAL},
+                {"8/8/4k3/8/8/8/4K3/8 w - - 0 1", chess::MATERIAL_DRAW, chess::SCALE_NORMAL},
+                {"8/8/4k3/8/8/3NN3/4K3/8 w - - 0 1", chess::MATERIAL_DRAWISH, chess::SCALE_NORMAL},
+                {"8/8/4k3/8/8/3B4/4K3/8 w - - 0 1", chess::MATERIAL_DRAW, chess::SCALE_NORMAL},
+                {"8/8/4k3/3n4/8/3B4/4K3/8 w - - 0 1", chess::MATERIAL_DRAWISH, chess::SCALE_NORMAL},
+                {"8/8/4k3/3b4/8/3R4/4K3/8 w - - 0 1", chess::MATERIAL_NORMAL, 16},
+                {"8/8/4k3/3r4/8/3RB3/4K3/8 w - - 0 1", chess::MATERIAL_NORMAL, 16},
+                {"8/8/4k3/3q4/8/3N4/4K3/8 w - - 0 1", chess::MATERIAL_NORMAL, chess::SCALE_NORMAL},
+                {"8/8/4k3/8/8/3RR3/4K3/8 b - - 0 1", chess::MATERIAL_WIN_WHITE, chess::SCALE_NORMAL},
+                {"8/8/4k3/8/3pp3/3q4/8/4K3 w - - 0 1", chess::MATERIAL_WIN_BLACK, chess::SCALE_NORMAL},
+                {"8/8/4k3/8/8/3R4/4K3/8 w - - 0 1", chess::MATERIAL_BITBASE, chess::SCALE_NORMAL},
+                {"8/8/4k3/8/8/3p4/4K3/8 w - - 0 1", chess::MATERIAL_BITBASE, chess::SCALE_NORMAL},
+                {"8/5p2/4kb2/8/8/3BP3/4K3/8 w - - 0 1", chess::MATERIAL_NORMAL, 16},
+                {"8/5p2/4kb2/8/8/2PBP3/4K3/8 w - - 0 1", chess::MATERIAL_NORMAL, 24}};
+
+        std::vector<std::string> failed;
+        for (const Test &test : tests) {
+            board.load(test.fen);
+            const chess::MaterialEntry &entry = chess::probe_material(board.get_material());
+            if (entry.kind != test.kind || entry.scale != test.scale) {
+                failed.emplace_back(test.fen);
+            }
+        }
+
+        if (failed.empty()) {
+            std::cout << "All material test have passed!" << std::endl;
+        } else {
+            std::cout << failed.size() << " material test have failed:" << std::endl;
+            for (const std::string &fen : failed) {
+                std::cout << fen << std::endl;
+            }
+            std::abort();
+        }
+    }
+
+} // namespace test
@@ -0,0 +1,399 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/board.h"
+#include "../chess/move_generation.h"
+#include "../network/activations/crelu.h"
+#include "../network/batch_eval.h"
+#include "../network/nnue.h"
+#include "../network/simd.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace test {
+
+    // Checks the int8 dot product, also with sizes that aren't a multiple of the register width.
+    template<typename KERNELS, size_t N>
+    void test_dot_epu8_epi8(std::mt19937 &mt, std::vector<std::string> &failed) {
+        std::uniform_int_distribution<int> dist_input(0, 127);
+        std::uniform_int_distribution<int> dist_weight(-128, 127);
+
+        alignas(64) std::array<uint8_t, N> input;
+        alignas(64) std::array<int8_t, N> weights;
+        for (size_t i = 0; i < N; i++) {
+            input[i] = dist_input(mt);
+            weights[i] = dist_weight(mt);
+        }
+
+        if (KERNELS::template dot_epu8_epi8<N>(input.data(), weights.data()) != nn::simd::Scalar::dot_epu8_epi8<N>(input.data(), weights.data())) {
+            failed.emplace_back(std::string(KERNELS::NAME) + "/" + std::to_string(N) + " dot_epu8_epi8");
+        }
+    }
+
+    template<typename KERNELS, size_t IN, size_t OUT>
+    void test_affine_epu8_epi8(std::mt19937 &mt, std::vector<std::string> &failed) {
+        std::uniform_int_distribution<int> dist_input(0, 127);
+        std::uniform_int_distribution<int> dist_weight(-128, 127);
+        std::uniform_int_distribution<int> dist_bias(-100000, 100000);
+
+        alignas(64) std::array<uint8_t, IN> input;
+        alignas(64) std::array<int8_t, IN * OUT> weights;
+        alignas(64) std::array<int32_t, OUT> biases, output_simd, output_scalar;
+        for (uint8_t &value : input) value = dist_input(mt);
+        for (int8_t &value : weights) value = dist_weight(mt);
+        for (int32_t &value : biases) value = dist_bias(mt);
+
+        KERNELS::template affine_epu8_epi8<IN, OUT>(input.data(), weights.data(), biases.data(), output_simd.data());
+        nn::simd::Scalar::affine_epu8_epi8<IN, OUT>(input.data(), weights.data(), biases.data(), output_scalar.data());
+        if (output_simd != output_scalar) {
+            failed.emplace_back(std::string(KERNELS::NAME) + "/" + std::to_string(IN) + "x" + std::to_string(OUT) + " affine_epu8_epi8");
+        }
+    }
+
+    // Checks the non-zero group search and the sparse layer on inputs where about half of the groups of 4 are zero.
+    template<typename KERNELS, size_t IN, size_t OUT>
+    void test_affine_sparse_epu8_epi8(std::mt19937 &mt, std::vector<std::string> &failed) {
+        std::uniform_int_distribution<int> dist_input(0, 127);
+        std::uniform_int_distribution<int> dist_weight(-128, 127);
+        std::uniform_int_distribution<int> dist_bias(-100000, 100000);
+        std::bernoulli_distribution dist_zero(0.5);
+
+        alignas(64) std::array<uint8_t, IN> input;
+        alignas(64) std::array<int8_t, IN * OUT> weights;
+        alignas(64) std::array<int32_t, OUT> biases, output_simd, output_scalar;
+        alignas(64) std::array<uint16_t, IN / 4> nnz_simd, nnz_scalar;
+        for (size_t i = 0; i < IN; i += 4) {
+            const bool zero = dist_zero(mt);
+            for (size_t j = i; j < i + 4; j++) input[j] = zero ? 0 : dist_input(mt);
+        }
+        for (int8_t &value : weights) value = dist_weight(mt);
+        for (int32_t &value : biases) value = dist_bias(mt);
+
+        const std::string name = std::string(KERNELS::NAME) + "/" + std::to_string(IN) + "x" + std::to_string(OUT);
+
+        const size_t count_simd = KERNELS::template find_nnz<IN>(input.data(), nnz_simd.data());
+        const size_t count_scalar = nn::simd::Scalar::find_nnz<IN>(input.data(), nnz_scalar.data());
+        if (count_simd != count_scalar || !std::equal(nnz_simd.begin(), nnz_simd.begin() + count_simd, nnz_scalar.begin())) {
+            failed.emplace_back(name + " find_nnz");
+            return;
+        }
+
+        KERNELS::template affine_sparse_epu8_epi8<IN, OUT>(input.data(), nnz_simd.data(), count_simd, weights.data(), biases.data(), output_simd.data());
+        nn::simd::Scalar::affine_epu8_epi8<IN, OUT>(input.data(), weights.data(), biases.data(), output_scalar.data());
+        if (output_simd != output_scalar) {
+            failed.emplace_back(name + " affine_sparse_epu8_epi8");
+        }
+    }
+
+    // Runs every kernel of KERNELS and the scalar reference on the same random data,
+    // and reports the name of each kernel whose result is not bit-identical.
+    template<typename KERNELS, size_t N>
+    void test_simd_kernels(std::mt19937 &mt, std::vector<std::string> &failed) {
+        using activation = nn::activations::crelu<int16_t, 64>;
+
+        std::uniform_int_distribution<int> dist_weight(-128, 128);
+        std::uniform_int_distribution<int> dist_acc(-2000, 2000);
+
+        alignas(64) std::array<int16_t, N> weights, weights2, acc_simd, acc_scalar, acc2_simd, acc2_scalar, out_simd, out_scalar;
+
+        for (size_t i = 0; i < N; i++) {
+            weights[i] = dist_weight(mt);
+            weights2[i] = dist_weight(mt);
+            acc_simd[i] = acc_scalar[i] = dist_acc(mt);
+            acc2_simd[i] = acc2_scalar[i] = dist_acc(mt);
+        }
+
+        const std::string name = std::string(KERNELS::NAME) + "/" + std::to_string(N);
+
+        KERNELS::template add_epi16<N>(acc_simd.data(), weights.data());
+        nn::simd::Scalar::add_epi16<N>(acc_scalar.data(), weights.data());
+        if (acc_simd != acc_scalar) failed.emplace_back(name + " add_epi16");
+
+        KERNELS::template sub_epi16<N>(acc_simd.data(), weights.data());
+        KERNELS::template sub_epi16<N>(acc_simd.data(), weights.data());
+        nn::simd::Scalar::sub_epi16<N>(acc_scalar.data(), weights.data());
+        nn::simd::Scalar::sub_epi16<N>(acc_scalar.data(), weights.data());
+        if (acc_simd != acc_scalar) failed.emplace_back(name + " sub_epi16");
+
+        KERNELS::template add2_epi16<N>(acc_simd.data(), weights.data(), acc2_simd.data(), weights2.data());
+        nn::simd::Scalar::add2_epi16<N>(acc_scalar.data(), weights.data(), acc2_scalar.data(), weights2.data());
+        if (acc_simd != acc_scalar || acc2_simd != acc2_scalar) failed.emplace_back(name + " add2_epi16");
+
+        KERNELS::template sub2_epi16<N>(acc_simd.data(), weights.data(), acc2_simd.data(), weights2.data());
+        nn::simd::Scalar::sub2_epi16<N>(acc_scalar.data(), weights.data(), acc2_scalar.data(), weights2.data());
+        if (acc_simd != acc_scalar || acc2_simd != acc2_scalar) failed.emplace_back(name + " sub2_epi16");
+
+        alignas(64) std::array<int16_t, N * 32> rows;
+        std::array<unsigned int, 24> features;
+        for (int16_t &value : rows) value = dist_weight(mt);
+        for (unsigned int &feature : features) feature = mt() % 32;
+        KERNELS::template accumulate_epi16<N>(acc_simd.data(), weights2.data(), rows.data(), features.data(), features.size());
+        nn::simd::Scalar::accumulate_epi16<N>(acc_scalar.data(), weights2.data(), rows.data(), features.data(), features.size());
+        if (acc_simd != acc_scalar) failed.emplace_back(name + " accumulate_epi16");
+
+        KERNELS::template activate_epi16<N, activation>(acc_simd.data(), out_simd.data());
+        nn::simd::Scalar::activate_epi16<N, activation>(acc_scalar.data(), out_scalar.data());
+        if (out_simd != out_scalar) failed.emplace_back(name + " activate_epi16");
+
+        const int32_t dot_simd = KERNELS::template dot_epi16<N>(out_simd.data(), weights.data());
+        const int32_t dot_scalar = nn::simd::Scalar::dot_epi16<N>(out_scalar.data(), weights.data());
+        if (dot_simd != dot_scalar) failed.emplace_back(name + " dot_epi16");
+
+        alignas(64) std::array<uint8_t, N> out8_simd, out8_scalar;
+        KERNELS::template activate_epu8<N, activation>(acc_simd.data(), out8_simd.data());
+        nn::simd::Scalar::activate_epu8<N, activation>(acc_scalar.data(), out8_scalar.data());
+        if (out8_simd != out8_scalar) failed.emplace_back(name + " activate_epu8");
+
+        test_dot_epu8_epi8<KERNELS, N>(mt, failed);
+    }
+
+    template<typename KERNELS>
+    void test_simd_kernels(std::mt19937 &mt, std::vector<std::string> &failed) {
+        for (int iteration = 0; iteration < 100; iteration++) {
+            test_simd_kernels<KERNELS, 256>(mt, failed);
+            test_simd_kernels<KERNELS, 512>(mt, failed);
+            test_simd_kernels<KERNELS, 1024>(mt, failed);
+            test_dot_epu8_epi8<KERNELS, 32>(mt, failed);
+            test_dot_epu8_epi8<KERNELS, 96>(mt, failed);
+            test_affine_epu8_epi8<KERNELS, 1024, 16>(mt, failed);
+            test_affine_epu8_epi8<KERNELS, 16, 32>(mt, failed);
+            test_affine_epu8_epi8<KERNELS, 36, 16>(mt, failed);
+            test_affine_sparse_epu8_epi8<KERNELS, 1024, 16>(mt, failed);
+            test_affine_sparse_epu8_epi8<KERNELS, 2048, 32>(mt, failed);
+        }
+    }
+
+    void test_simd() {
+        std::mt19937 mt(RANDOM_SEED);
+        std::vector<std::string> failed;
+        std::string tested = "scalar";
+
+#ifdef KERNELS_AVX2
+        if (cpu::features.avx2) {
+            test_simd_kernels<nn::simd::Avx2>(mt, failed);
+            tested += " avx2";
+        }
+#endif
+#ifdef KERNELS_AVX512
+        if (cpu::features.avx512) {
+            test_simd_kernels<nn::simd::Avx512>(mt, failed);
+            tested += " avx512";
+        }
+#endif
+#ifdef KERNELS_VNNI512
+        if (cpu::features.vnni512) {
+            test_simd_kernels<nn::simd::Vnni512>(mt, failed);
+            tested += " avx512-vnni";
+        }
+#endif
+
+        if (failed.empty()) {
+            std::cout << "All simd test have passed! (" << tested << ", selected " << nn::simd::get_name() << ")" << std::endl;
+        } else {
+            std::cout << failed.size() << " simd test have failed:" << std::endl;
+            for (const std::string &name : failed) {
+                std::cout << name << std::endl;
+            }
+            std::abort();
+        }
+    }
+
+    // Writes network as a network file, maps it back, and checks that both evaluate identically.
+    template<typename NETWORK>
+    void test_network_file(const NETWORK &network, const std::string &name, std::vector<std::string> &failed) {
+        const std::vector<std::string> fens = {
+                STARTING_FEN,
+                "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1"};
+
+        const std::string path = "network_file_test.bin";
+        nn::write_network(network, path);
+
+        {
+            const nn::LoadedNetwork loaded(path);
+            if (!loaded.is_mapped()) failed.emplace_back(name + " was copied instead of mapped");
+            if (!std::holds_alternative<const NETWORK *>(loaded.get())) failed.emplace_back(name + " was loaded as " + loaded.describe());
+
+            nn::NNUE original{nn::NetworkRef(&network)}, mapped{loaded.get()};
+            chess::Board board;
+            for (const std::string &fen : fens) {
+                board.load(fen);
+                original.refresh(board.to_features());
+                mapped.refresh(board.to_features());
+                if (original.evaluate(board.get_stm()) != mapped.evaluate(board.get_stm())) failed.emplace_back(name + " " + fen);
+            }
+        }
+        std::remove(path.c_str());
+    }
+
+    // Plays random moves with incremental updates, takes them back, and checks that the evaluation matches a full refresh.
+    // The second position has few pieces, so that the kings often change their bucket.
+    template<typename NETWORK>
+    void test_incremental_updates(const NETWORK &network, const std::string &name, std::mt19937 &mt, std::vector<std::string> &failed) {
+        const std::vector<std::string> fens = {
+                "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                "r3k2r/2p5/8/8/8/8/5P2/R3K2R w KQkq - 0 1"};
+
+        for (const std::string &fen : fens) {
+            chess::Board board;
+            board.load(fen);
+
+            nn::NNUE incremental{nn::NetworkRef(&network)}, refreshed{nn::NetworkRef(&network)};
+            incremental.refresh(board.to_features());
+
+            auto matches = [&]() {
+                refreshed.refresh(board.to_features());
+                return incremental.evaluate(board.get_stm()) == refreshed.evaluate(board.get_stm());
+            };
+
+            std::vector<chess::Move> played;
+            for (int ply = 0; ply < 40; ply++) {
+                chess::Move moves[200];
+                chess::Move *moves_end = chess::gen_moves(board, moves, false);
+                if (moves_end == moves) break;
+
+                played.emplace_back(moves[mt() % (moves_end - moves)]);
+                board.make_move(played.back(), &incremental);
+
+                if (!matches()) {
+                    failed.emplace_back(name + " incremental update at ply " + std::to_string(ply) + " from " + fen);
+                    break;
+                }
+            }
+
+            while (!played.empty()) {
+                board.undo_move(played.back(), &incremental);
+                played.pop_back();
+
+                if (!matches()) {
+                    failed.emplace_back(name + " undo at ply " + std::to_string(played.size()) + " from " + fen);
+                    break;
+                }
+            }
+        }
+    }
+
+    template<typename... NETWORKS>
+    void test_network_files(nn::ArchitectureList<NETWORKS...>, std::mt19937 &mt, std::vector<std::string> &failed) {
+        std::uniform_int_distribution<int> dist(0, 3);
+        auto test_random_network = [&](auto network) {
+            using NETWORK = typename decltype(network)::element_type;
+            unsigned char *bytes = reinterpret_cast<unsigned char *>(network.get());
+            for (size_t i = 0; i < sizeof(NETWORK); i++) {
+                bytes[i] = dist(mt);
+            }
+            test_network_file(*network, NETWORK::get_header().describe(), failed);
+            test_incremental_updates(*network, NETWORK::get_header().describe(), mt, failed);
+        };
+        (test_random_network(std::make_unique<NETWORKS>()), ...);
+    }
+
+    // Evaluates positions on several threads, and checks that the scores match evaluating them one by one.
+    void test_batch_eval(std::vector<std::string> &failed) {
+        const std::vector<std::string> valid = {
+                STARTING_FEN,
+                "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0;12;b4b1;-10;0;",
+                "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+                "8/8/4k3/8/8/3NK3/8/8 b - - 0 1"};
+        const std::vector<std::string> invalid = {
+                "8/8/8/8 w - - 0 1",
+                "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",
+                "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQ1BNR w kq - 0 1"};
+
+        std::vector<std::string> fens = valid;
+        fens.insert(fens.end(), invalid.begin(), invalid.end());
+
+        eval::BatchEvaluator evaluator(nn::get_default_network(), 3);
+        std::vector<std::optional<Score>> scores;
+        evaluator.evaluate(fens, scores);
+
+        nn::NNUE nnue;
+        chess::Board board;
+        for (size_t i = 0; i < fens.size(); i++) {
+            if (i >= valid.size()) {
+                if (scores[i]) failed.emplace_back("batch evaluation accepted " + fens[i]);
+                continue;
+            }
+            board.load(fens[i].substr(0, fens[i].find(';')));
+            nnue.refresh(board.to_features());
+            if (scores[i] != eval::evaluate(board, nnue)) failed.emplace_back("batch evaluation of " + fens[i]);
+        }
+
+        // Evaluating a file of several blocks keeps the order of the lines, the files are unique to this run
+        const std::string suffix = std::to_string(std::random_device()());
+        const std::filesystem::path input_path = std::filesystem::temp_directory_path() / ("whitecore_batch_input_" + suffix + ".txt");
+        const std::filesystem::path output_path = std::filesystem::temp_directory_path() / ("whitecore_batch_output_" + suffix + ".txt");
+        std::vector<std::string> expected;
+        size_t expected_invalid = 0;
+        {
+            std::ofstream input(input_path);
+            for (size_t i = 0; i < 2 * eval::BatchEvaluator::BLOCK_SIZE + 5; i++) {
+                const size_t index = i % fens.size();
+                input << fens[index] << "\n";
+                if (index < valid.size()) {
+                    expected.emplace_back(fens[index] + (fens[index].back() != ';' ? ";" : "") + std::to_string(*scores[index]) + ";");
+                } else {
+                    expected_invalid++;
+                }
+            }
+        }
+
+        const eval::BatchCounts counts = evaluator.evaluate_file(input_path.string(), output_path.string());
+        std::ifstream output(output_path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(output, line);) {
+            lines.emplace_back(line);
+        }
+        if (counts.evaluated != expected.size() || counts.invalid != expected_invalid || lines != expected) failed.emplace_back("batch evaluation of a file");
+
+        std::filesystem::remove(input_path);
+        std::filesystem::remove(output_path);
+    }
+
+    void test_network_file() {
+        std::mt19937 mt(RANDOM_SEED);
+        std::vector<std::string> failed;
+
+        std::visit([&](auto *network) { test_network_file(*network, "default network", failed); }, nn::get_default_network());
+        test_network_files(nn::Architectures(), mt, failed);
+        test_batch_eval(failed);
+
+        if (failed.empty()) {
+            std::cout << "All network file test have passed!" << std::endl;
+        } else {
+            std::cout << failed.size() << " network file test have failed:" << std::endl;
+            for (const std::string &name : failed) {
+                std::cout << name << std::endl;
+            }
+            std::abort();
+        }
+    }
+
+} // namespace test
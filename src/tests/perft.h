@@ -17,37 +17,174 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "../chess/move_generation.h"
 
 namespace test {
 
-    template<bool bulk_counting, bool output>
-    int64_t perft(chess::Board &board, int depth) {
-        chess::Move moves[200];
-        chess::Move *moves_end = chess::gen_moves(board, moves, false);
+    // Caches the node counts of subtrees by the Zobrist hash and the depth, shared between the perft threads.
+    // Entries are always replaced. The key is stored xored with the count, so a torn write is seen as a miss.
+    class PerftTable {
+
+    public:
+        explicit PerftTable(size_t mb) : size(std::max<size_t>(mb * 1024 * 1024 / sizeof(Entry), 1)), table(new Entry[size]) {}
 
+        [[nodiscard]] std::optional<int64_t> probe(chess::Zobrist hash, int depth) const {
+            const uint64_t key = get_key(hash, depth);
+            const Entry &entry = table[key % size];
+            const uint64_t nodes = entry.nodes.load(std::memory_order_relaxed);
+            if ((entry.check.load(std::memory_order_relaxed) ^ nodes) != key) {
+                return std::nullopt;
+            }
+            return int64_t(nodes);
+        }
+
+        void save(chess::Zobrist hash, int depth, int64_t nodes) {
+            const uint64_t key = get_key(hash, depth);
+            Entry &entry = table[key % size];
+            entry.check.store(key ^ uint64_t(nodes), std::memory_order_relaxed);
+            entry.nodes.store(uint64_t(nodes), std::memory_order_relaxed);
+        }
+
+    private:
+        struct Entry {
+            std::atomic<uint64_t> check{0};
+            std::atomic<uint64_t> nodes{0};
+        };
+
+        size_t size;
+        std::unique_ptr<Entry[]> table;
+
+        [[nodiscard]] static uint64_t get_key(chess::Zobrist hash, int depth) {
+            return uint64_t(hash) ^ (uint64_t(depth) * 0x9E3779B97F4A7C15ULL);
+        }
+    };
+
+    template<bool bulk_counting, bool output>
+    int64_t perft(chess::Board &board, int depth, PerftTable *table = nullptr) {
         // Bulk counting the number of moves at depth 1.
         if (depth == 1 && bulk_counting)
-            return moves_end - moves;
+            return chess::count_moves(board);
         if (depth == 0)
             return 1;
 
+        if (table) {
+            if (std::optional<int64_t> nodes = table->probe(board.get_hash(), depth)) {
+                return *nodes;
+            }
+        }
+
+        chess::Move moves[200];
+        chess::Move *moves_end = chess::gen_moves(board, moves, false);
+
         // DFS like routine, calling itself recursively with lowered depth.
         int64_t nodes = 0;
         for (chess::Move *it = moves; it != moves_end; it++) {
             board.make_move(*it);
-            int64_t node_count = perft<bulk_counting, false>(board, depth - 1);
+            int64_t node_count = perft<bulk_counting, false>(board, depth - 1, table);
             if constexpr (output) {
                 std::cout << *it << ": " << node_count << std::endl; // Used for debugging purposes.
             }
             nodes += node_count;
             board.undo_move(*it);
         }
+
+        if (table) {
+            table->save(board.get_hash(), depth, nodes);
+        }
+        return nodes;
+    }
+
+    // The number of threads perft_parallel runs, as there is no work for more threads than root moves.
+    size_t perft_thread_count(const chess::Board &board, int depth, size_t thread_count) {
+        if (depth <= 1) return 1;
+        chess::Move moves[200];
+        const size_t move_count = chess::gen_moves(board, moves, false) - moves;
+        return std::clamp<size_t>(thread_count, 1, std::max<size_t>(move_count, 1));
+    }
+
+    // Runs a bulk counting perft on multiple threads, which take the root moves one by one from a shared queue.
+    // With a non-zero hash size, the subtree counts are cached in a PerftTable.
+    int64_t perft_parallel(const chess::Board &board, int depth, size_t thread_count, size_t hash_mb = 0) {
+        if (depth <= 1) {
+            chess::Board copy = board;
+            return perft<true, false>(copy, depth);
+        }
+
+        chess::Move moves[200];
+        const size_t move_count = chess::gen_moves(board, moves, false) - moves;
+
+        std::unique_ptr<PerftTable> table = hash_mb != 0 ? std::make_unique<PerftTable>(hash_mb) : nullptr;
+        std::atomic<size_t> next_move = 0;
+        std::atomic<int64_t> nodes = 0;
+
+        std::vector<std::thread> threads;
+        for (size_t id = 0; id < perft_thread_count(board, depth, thread_count); id++) {
+            threads.emplace_back([&]() {
+                chess::Board copy = board;
+                for (size_t i = next_move++; i < move_count; i = next_move++) {
+                    copy.make_move(moves[i]);
+                    nodes += perft<true, false>(copy, depth - 1, table.get());
+                    copy.undo_move(moves[i]);
+                }
+            });
+        }
+        for (std::thread &th : threads) {
+            th.join();
+        }
         return nodes;
     }
 
+    // Compares the counted moves to the generated ones in every node up to 'depth'.
+    bool count_moves_matches(chess::Board &board, int depth) {
+        chess::Move moves[200];
+        chess::Move *moves_end = chess::gen_moves(board, moves, false);
+        const int64_t expected = moves_end - moves;
+
+        if (chess::count_moves(board) != expected || chess::has_legal_move(board) != (expected != 0)) {
+            std::cout << "Move counting mismatch in " << board.get_fen() << std::endl;
+            return false;
+        }
+
+        for (chess::Move *it = moves; depth > 1 && it != moves_end; it++) {
+            board.make_move(*it);
+            const bool matches = count_moves_matches(board, depth - 1);
+            board.undo_move(*it);
+            if (!matches) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void test_count_moves() {
+        const std::vector<std::string> fens = {
+                STARTING_FEN,
+                "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ",
+                "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - ",
+                "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1 ",
+                "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 ",
+                "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3",
+                "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"};
+
+        chess::Board board;
+        for (const std::string &fen : fens) {
+            board.load(fen);
+            if (!count_moves_matches(board, 3)) {
+                std::abort();
+            }
+        }
+
+        std::cout << "All move counting test have passed!" << std::endl;
+    }
+
     void test_perft() {
 
         struct Test {
@@ -70,12 +207,13 @@ namespace test {
         std::cout << "Testing perft..." << std::endl;
         chess::Board board;
         std::vector<Test> failed;
+        const size_t thread_count = std::max(std::thread::hardware_concurrency(), 1u);
         int64_t start_time = now(), total_nodes = 0;
 
         for (const Test &test : tests) {
             board.load(test.fen);
             std::cout << "Running " << test.fen << "...\r" << std::flush;
-            int64_t node_count = perft<true, false>(board, test.depth);
+            int64_t node_count = perft_parallel(board, test.depth, thread_count);
             total_nodes += node_count;
             if (node_count != test.expected) {
                 failed.emplace_back(test);
@@ -86,8 +224,16 @@ namespace test {
         int64_t end_time = now();
         int64_t nps = calculate_nps(end_time - start_time, total_nodes);
 
+        // The cached counts must add up to the same totals
+        for (const Test &test : tests) {
+            board.load(test.fen);
+            if (perft_parallel(board, test.depth, thread_count, 16) != test.expected) {
+                failed.emplace_back(test);
+            }
+        }
+
         if (failed.empty()) {
-            std::cout << "All perft test have passed! " << nps << " nps" << std::endl;
+            std::cout << "All perft test have passed! " << nps << " nps on " << thread_count << " threads" << std::endl;
         } else {
             std::cout << failed.size() << " perft test have failed:" << std::endl;
             for (const Test &test : failed) {
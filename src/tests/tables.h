@@ -0,0 +1,89 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "../chess/attacks.h"
+#include "../search/search_manager.h"
+
+#include <cmath>
+#include <iostream>
+
+namespace test {
+
+    // Compares the attacks on every occupancy of the magic masks to the naive attack generation.
+    template<PieceType pt, typename F>
+    bool test_attack_table(const chess::Magic *magics, F attacks) {
+        for (Square square = A1; square < 64; square += 1) {
+            const chess::Magic &magic = magics[square];
+            chess::Bitboard occ = 0;
+            do {
+                // The squares outside the mask must not change the attacks, except the square of the piece itself for the naive generation
+                const chess::Bitboard occupied = occ | (~magic.mask & ~chess::Bitboard(square) & 0x8142241818244281ULL);
+                if (attacks(square, occupied) != chess::attacks_sliding_slow(square, occupied, pt)) {
+                    std::cout << "Attack table mismatch on " << format_square(square) << " for occupancy " << occupied.bb << std::endl;
+                    return false;
+                }
+                occ = (occ - magic.mask) & magic.mask;
+            } while (occ != 0);
+        }
+        return true;
+    }
+
+    bool test_sliding_attacks() {
+        return test_attack_table<ROOK>(chess::magic_rook, chess::attacks_rook) && test_attack_table<BISHOP>(chess::magic_bishop, chess::attacks_bishop);
+    }
+
+    // Checks the tables generated at compile time, and the sliding attacks.
+    void test_tables() {
+        bool passed = test_sliding_attacks();
+
+#ifdef DISPATCH
+        // Dispatch builds contain the tables of both layouts, the one not used on this CPU is checked as well if possible.
+        if (cpu::features.bmi2) {
+            chess::use_pext = !chess::use_pext;
+            passed = passed && test_sliding_attacks();
+            chess::use_pext = !chess::use_pext;
+        }
+#endif
+
+#ifdef KERNELS_AVX2
+        if (cpu::features.avx2) {
+            passed = passed && test_attack_table<ROOK>(chess::magic_rook, chess::kogge_stone::attacks_rook) &&
+                     test_attack_table<BISHOP>(chess::magic_bishop, chess::kogge_stone::attacks_bishop);
+        }
+#endif
+
+        for (int made_moves = 0; made_moves < 200; made_moves++) {
+            for (Depth depth = 0; depth < MAX_PLY + 1; depth++) {
+                double moves_log = made_moves == 0 ? 0 : std::log(made_moves);
+                double depth_log = depth == 0 ? 0 : std::log(depth);
+                if (search::lmr_reductions[made_moves][depth] != Depth(1.0 + moves_log * depth_log / 2.0)) {
+                    std::cout << "Reduction mismatch for " << made_moves << " moves at depth " << int(depth) << std::endl;
+                    passed = false;
+                }
+            }
+        }
+
+        if (passed) {
+            std::cout << "All table test have passed!" << std::endl;
+        } else {
+            std::abort();
+        }
+    }
+
+} // namespace test
@@ -17,15 +17,27 @@
 
 #pragma once
 
+#include "bitbase.h"
+#include "fen.h"
 #include "hash.h"
+#include "material.h"
+#include "nnue.h"
 #include "perft.h"
 #include "repetition.h"
+#include "tables.h"
 
 namespace test {
 
     void run() {
+        test_simd();
+        test_network_file();
+        test_tables();
+        test_fen();
         test_hash();
+        test_material();
+        test_bitbase();
         test_repetition();
+        test_count_moves();
         test_perft();
     }
 
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../chess/board.h"
+#include "../network/batch_eval.h"
 #include "../network/train.h"
 #include "../search/search_manager.h"
 #include "../selfplay/selfplay.h"
@@ -44,7 +45,11 @@ namespace uci {
         std::vector<Option> options;
         bool should_continue = true;
         chess::Board board;
+        // The position of the last position command, which the next one can continue from
+        std::string position_fen;
+        std::vector<std::string> position_moves;
         search::SearchManager sm;
+        std::unique_ptr<nn::LoadedNetwork> eval_file;
 
         void register_commands();
 
@@ -52,6 +57,8 @@ namespace uci {
 
         void greetings();
 
+        void load_eval_file(const std::string &path);
+
         search::Limits parse_limits(context tokens);
 
         void parse_position(context tokens);
@@ -62,6 +69,8 @@ namespace uci {
 
         void parse_quantize(context tokens);
 
+        void parse_evalbatch(context tokens);
+
         void parse_train(context tokens);
 
         static std::vector<std::string> convert_to_tokens(const std::string &line);
@@ -89,10 +98,13 @@ namespace uci {
             board.display();
         });
         commands.emplace_back("eval", [&](context tokens) {
-            nn::NNUE network{};
+            nn::NNUE network{sm.get_network()};
             network.refresh(board.to_features());
             print("Eval:", eval::evaluate(board, network));
         });
+        commands.emplace_back("evalbatch", [&](context tokens) {
+            parse_evalbatch(tokens);
+        });
         commands.emplace_back("gen", [&](context tokens) {
             parse_gen(tokens);
         });
@@ -107,7 +119,15 @@ namespace uci {
         });
         commands.emplace_back("perft", [&](context tokens) {
             int depth = find_element<int>(tokens, "perft").value_or(5);
-            uint64_t node_count = test::perft<true, false>(board, depth);
+            size_t thread_count = std::max(find_element<int>(tokens, "threads").value_or(get_option<int>("Threads")), 1);
+            size_t hash_mb = std::max(find_element<int>(tokens, "hash").value_or(0), 0);
+            thread_count = test::perft_thread_count(board, depth, thread_count);
+
+            int64_t start_time = now();
+            uint64_t node_count = test::perft_parallel(board, depth, thread_count, hash_mb);
+            int64_t elapsed = now() - start_time, nps = calculate_nps(elapsed, node_count);
+
+            print("info", "string", "perft", "threads", thread_count, "hash", hash_mb, "time", elapsed, "nps", nps, "nps/thread", nps / thread_count);
             print("Total node count: ", node_count);
         });
         commands.emplace_back("go", [&](context tokens) {
@@ -155,6 +175,11 @@ namespace uci {
                 },
                 0, 1000);
 
+        options.emplace_back(
+                "EvalFile", "<default>", "string", [&]() {
+                    load_eval_file(get_option<std::string>("EvalFile"));
+                });
+
         options.emplace_back(
                 "UCI_ShowWDL", "false", "check", [&]() {
                     search::report::set_show_wdl(get_option<bool>("UCI_ShowWDL"));
@@ -195,9 +220,27 @@ namespace uci {
         }
     }
 
+    void UCI::load_eval_file(const std::string &path) {
+        if (path == "<default>" || path.empty()) {
+            sm.set_network(nn::get_default_network());
+            eval_file.reset();
+            return;
+        }
+
+        try {
+            auto network = std::make_unique<nn::LoadedNetwork>(path);
+            sm.set_network(network->get());
+            eval_file = std::move(network);
+            print("info", "string", "Loaded network", path, eval_file->is_mapped() ? "(mapped)" : "(copied)", eval_file->describe());
+        } catch (const std::exception &e) {
+            print("info", "string", "error", "Unable to load network", path + ":", e.what());
+        }
+    }
+
     void UCI::greetings() {
         print("id", "name", "WhiteCore", VERSION);
         print("id author Balazs Szilagyi");
+        print("info", "string", "kernels", nn::simd::get_name(), "sliders", chess::get_sliding_attacks_name());
         for (const Option &opt : options) {
             print(opt.to_string());
         }
@@ -224,16 +267,28 @@ namespace uci {
 
     void UCI::parse_position(UCI::context tokens) {
         unsigned int idx = 2;
-        if (tokens[1] == "startpos") {
-            board.load(STARTING_FEN);
-        } else {
-            std::string fen;
+        std::string fen = STARTING_FEN;
+        if (tokens[1] != "startpos") {
+            fen.clear();
             for (; idx < tokens.size() && tokens[idx] != "moves"; idx++) {
                 fen += tokens[idx] + " ";
             }
-            board.load(fen, true);
         }
         if (idx < tokens.size() && tokens[idx] == "moves") idx++;
+
+        // During a game every position command repeats the previous one with the new moves appended,
+        // in which case only the new moves are played instead of replaying the whole game.
+        const bool extends_previous = fen == position_fen && tokens.size() - idx >= position_moves.size() &&
+                                      std::equal(position_moves.begin(), position_moves.end(), tokens.begin() + idx);
+        if (extends_previous) {
+            idx += position_moves.size();
+        } else {
+            position_moves.clear();
+            position_fen.clear();
+            if (!board.load(fen, tokens[1] != "startpos")) return;
+            position_fen = fen;
+        }
+
         for (; idx < tokens.size(); idx++) {
             chess::Move move = move_from_string(board, tokens[idx]);
             if (move == chess::NULL_MOVE) {
@@ -241,6 +296,7 @@ namespace uci {
                 break;
             } else {
                 board.make_move(move);
+                position_moves.emplace_back(tokens[idx]);
             }
         }
     }
@@ -251,14 +307,33 @@ namespace uci {
         limits.depth = find_element<int64_t>(tokens, "depth");
         std::optional<size_t> thread_count = find_element<size_t>(tokens, "threads");
         std::optional<int> games_to_play = find_element<int>(tokens, "games");
-        selfplay::start_generation(limits, games_to_play.value_or(100'000), thread_count.value_or(1));
+        std::optional<std::string> format = find_element<std::string>(tokens, "format");
+        selfplay::start_generation(limits, games_to_play.value_or(100'000), thread_count.value_or(1), format == "packed");
     }
 
     void UCI::parse_quantize(uci::UCI::context tokens) {
         std::optional<std::string> input = find_element<std::string>(tokens, "input");
         std::optional<std::string> output = find_element<std::string>(tokens, "output");
-        nn::Network network_file(input.value_or("input.bin"));
-        network_file.quantize<int16_t, nn::NNUE::QSCALE>(output.value_or("output.bin"));
+        auto network_file = std::make_unique<nn::Network>(input.value_or("input.bin"));
+        network_file->quantize<int16_t, nn::NNUE::QSCALE>(output.value_or("output.bin"));
+    }
+
+    void UCI::parse_evalbatch(uci::UCI::context tokens) {
+        std::optional<std::string> input = find_element<std::string>(tokens, "input");
+        std::optional<std::string> output = find_element<std::string>(tokens, "output");
+        std::optional<size_t> thread_count = find_element<size_t>(tokens, "threads");
+        try {
+            eval::BatchEvaluator evaluator(sm.get_network(), thread_count.value_or(1));
+            const int64_t start_time = now();
+            const eval::BatchCounts counts = evaluator.evaluate_file(input.value_or("data.plain"), output.value_or("eval.plain"));
+            const int64_t elapsed_time = std::max<int64_t>(now() - start_time, 1);
+            if (counts.invalid != 0) {
+                print("info", "string", "Skipped", counts.invalid, "invalid positions");
+            }
+            print("info", "string", "Evaluated", counts.evaluated, "positions in", elapsed_time, "ms,", counts.evaluated * 1000 / elapsed_time, "positions/s");
+        } catch (const std::exception &e) {
+            print("info", "string", "error", e.what());
+        }
     }
 
     void UCI::parse_split(uci::UCI::context tokens) {
@@ -278,8 +353,9 @@ namespace uci {
         std::optional<size_t> epochs = find_element<size_t>(tokens, "epochs");
         std::optional<size_t> batch_size = find_element<size_t>(tokens, "batch");
         std::optional<size_t> threads = find_element<size_t>(tokens, "threads");
-        nn::Trainer trainer(training_data.value_or("train.plain"), validation_data.value_or("validation.plain"), network_path, learning_rate.value_or(0.001f),
-                            eval_influence.value_or(0.9f), epochs.value_or(20), batch_size.value_or(16384), threads.value_or(4));
+        // The trainer holds several copies of the network, which do not fit on the stack
+        auto trainer = std::make_unique<nn::Trainer>(training_data.value_or("train.plain"), validation_data.value_or("validation.plain"), network_path, learning_rate.value_or(0.001f),
+                                                     eval_influence.value_or(0.9f), epochs.value_or(20), batch_size.value_or(16384), threads.value_or(4));
     }
 
     std::vector<std::string> UCI::convert_to_tokens(const std::string &line) {
@@ -0,0 +1,82 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "utilities.h"
+
+#include <cstdlib>
+
+namespace cpu {
+
+    struct Features {
+        bool popcnt = false;
+        bool bmi2 = false;
+        bool fast_pext = false;
+        bool avx2 = false;
+        bool avx512 = false;
+        bool vnni512 = false;
+    };
+
+    Features features;
+
+    // Queries the instruction sets supported by the CPU and the operating system.
+    Features detect() {
+        Features result;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        result.popcnt = __builtin_cpu_supports("popcnt");
+        result.bmi2 = __builtin_cpu_supports("bmi2");
+        // PEXT is microcoded on AMD CPUs before Zen 3, multiply magics are faster there.
+        result.fast_pext = result.bmi2 && !__builtin_cpu_is("amdfam15h") && !__builtin_cpu_is("amdfam17h");
+        result.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi");
+        result.avx512 = result.avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        result.vnni512 = result.avx512 && __builtin_cpu_supports("avx512vnni");
+#endif
+        return result;
+    }
+
+    // Detects the CPU features, and exits with an error instead of crashing with an illegal instruction
+    // later on, if the binary was compiled for instructions that the CPU doesn't support.
+    void init() {
+        features = detect();
+
+        auto require = [](bool supported, const std::string &name) {
+            if (!supported) {
+                print("info", "string", "error", "This binary requires", name, "which is not supported by this CPU");
+                std::exit(1);
+            }
+        };
+
+#ifdef __POPCNT__
+        require(features.popcnt, "popcnt");
+#endif
+#ifdef BMI2
+        require(features.bmi2, "bmi2");
+#endif
+#ifdef AVX2
+        require(features.avx2, "avx2");
+#endif
+#ifdef AVX512
+        require(features.avx512, "avx512");
+#endif
+#ifdef VNNI512
+        require(features.vnni512, "avx512-vnni");
+#endif
+    }
+
+} // namespace cpu
@@ -0,0 +1,140 @@
+// WhiteCore is a C++ chess engine
+// Copyright (c) 2022-2025 Balázs Szilágyi
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+// windows.h defines these as annotation macros, which would clash with the layer template parameters
+#undef IN
+#undef OUT
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A read-only memory mapping of a whole file. The pages are backed by the page cache,
+// so every process mapping the same file shares the same physical memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path) {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Unable to open: " + path);
+        }
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(file);
+            throw std::runtime_error("Unable to map empty file: " + path);
+        }
+
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            throw std::runtime_error("Unable to map: " + path);
+        }
+
+        ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (ptr == nullptr) {
+            CloseHandle(mapping);
+            throw std::runtime_error("Unable to map: " + path);
+        }
+        length = file_size.QuadPart;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("Unable to open: " + path);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == -1 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("Unable to map empty file: " + path);
+        }
+
+        ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (ptr == MAP_FAILED) {
+            ptr = nullptr;
+            throw std::runtime_error("Unable to map: " + path);
+        }
+        length = st.st_size;
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept {
+        swap(other);
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~MappedFile() {
+        if (ptr == nullptr) return;
+#if defined(_WIN32)
+        UnmapViewOfFile(ptr);
+        CloseHandle(mapping);
+#else
+        munmap(ptr, length);
+#endif
+    }
+
+    [[nodiscard]] const unsigned char *data() const {
+        return static_cast<const unsigned char *>(ptr);
+    }
+
+    [[nodiscard]] size_t size() const {
+        return length;
+    }
+
+private:
+    void *ptr = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    HANDLE mapping = nullptr;
+#endif
+
+    void swap(MappedFile &other) noexcept {
+        std::swap(ptr, other.ptr);
+        std::swap(length, other.length);
+#if defined(_WIN32)
+        std::swap(mapping, other.mapping);
+#endif
+    }
+};
@@ -80,11 +80,7 @@ std::string uci_to_san(const chess::Move &move, const chess::Board &x) {
 
     board.make_move(move);
 
-    chess::Move buffer[200];
-    chess::Move *end_ptr = chess::gen_moves(board, buffer, false);
-    size_t move_count = end_ptr - buffer;
-
-    if (move_count == 0) {
+    if (!chess::has_legal_move(board)) {
         if (board.is_check()) {
             san_move << "# ";
             if (board.get_stm() == WHITE) {
@@ -17,23 +17,35 @@
 
 #pragma once
 
+#include "../chess/packed_board.h"
+
+#include <fstream>
 #include <random>
 
 void split_data(const std::string &input, const std::string &output1, const std::string &output2, int rate) {
-    std::ifstream in(input, std::ios::in);
-    std::ofstream out1(output1, std::ios::out | std::ios::app);
-    std::ofstream out2(output2, std::ios::out | std::ios::app);
+    const bool packed = chess::is_packed_data(input);
+    const std::ios::openmode mode = packed ? std::ios::binary : std::ios::openmode();
+    std::ifstream in(input, std::ios::in | mode);
+    std::ofstream out1(output1, std::ios::out | std::ios::app | mode);
+    std::ofstream out2(output2, std::ios::out | std::ios::app | mode);
 
     std::random_device rd;
     std::mt19937 g(rd());
     std::uniform_int_distribution<int> dist(0, rate);
 
-    std::string line;
-    while (std::getline(in, line)) {
-        if (dist(g) == 0)
-            out2 << line << "\n";
-        else
-            out1 << line << "\n";
+    if (packed) {
+        chess::PackedBoard record;
+        while (in.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+            (dist(g) == 0 ? out2 : out1).write(reinterpret_cast<const char *>(&record), sizeof(record));
+        }
+    } else {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (dist(g) == 0)
+                out2 << line << "\n";
+            else
+                out1 << line << "\n";
+        }
     }
 
     in.close();
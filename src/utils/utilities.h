@@ -140,19 +140,19 @@ constexpr int64_t calculate_nps(int64_t time, int64_t nodes) {
     return nodes * 1000 / (time + 1);
 }
 
-Square operator+(Square a, int b) {
+constexpr Square operator+(Square a, int b) {
     return Square(int(a) + b);
 }
 
-Square operator-(Square a, int b) {
+constexpr Square operator-(Square a, int b) {
     return Square(int(a) - b);
 }
 
-Square operator+=(Square &a, int b) {
+constexpr Square operator+=(Square &a, int b) {
     return a = a + b;
 }
 
-Square operator-=(Square &a, int b) {
+constexpr Square operator-=(Square &a, int b) {
     return a = a - b;
 }
 